@@ -1,11 +1,28 @@
 #ifndef ING_LOGGING_HPP
 #define ING_LOGGING_HPP
 
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <ostream>
 #include <istream>
+#include <iterator>
+#include <string>
 #include <string_view>
+#include <tuple>
 #include <type_traits>
+#include <vector>
 
+#include <boost/log/attributes/attribute_value_impl.hpp>
+#include <boost/log/attributes/value_extraction.hpp>
+#include <boost/log/detail/default_attribute_names.hpp>
 #include <boost/log/keywords/log_source.hpp>
 #include <boost/log/sources/severity_feature.hpp>
 #include <boost/log/sources/channel_feature.hpp>
@@ -13,8 +30,10 @@
 #include <boost/log/sources/record_ostream.hpp>
 #include <boost/log/sources/global_logger_storage.hpp>
 #include <boost/mp11/map.hpp>
+#include <boost/parameter/keyword.hpp>
 
 #include "source_location.hpp"
+#include "spinlock.hpp"
 
 #if defined(ING_WITH_FMT)
 #define ING_HAS_FMT
@@ -92,10 +111,33 @@ namespace ing::fmt
     using fmtloc_t = std::enable_if_t<
                         !std::disjunction_v<std::is_convertible<Args, format_args>...>,
                         format_location<Args...>>;
+
+    /**
+     * @brief Arguments that can be copied bytewise and formatted later on another thread, i.e. they
+     * do not refer to any external storage. Specialize it for other trivially copyable types.
+     */
+    template<typename T>
+    struct is_deferrable : std::bool_constant<std::is_arithmetic_v<T> || std::is_enum_v<T>> {};
+
+    template<typename Rep, typename Period>
+    struct is_deferrable<std::chrono::duration<Rep, Period>> : std::true_type {};
+
+    template<typename Clock, typename Duration>
+    struct is_deferrable<std::chrono::time_point<Clock, Duration>> : std::true_type {};
+
+    template<typename ...Args>
+    inline constexpr bool is_deferrable_v = sizeof...(Args) > 0 &&
+                                            (is_deferrable<std::decay_t<Args>>::value && ...);
 }
 #endif
 
 
+// Ordinal of the minimum severity level compiled in, records below it are eliminated at compile time.
+// It must be the same for all translation units of a program.
+#ifndef ING_LOG_ACTIVE_LEVEL
+#define ING_LOG_ACTIVE_LEVEL 0
+#endif
+
 namespace ing::logging
 {
     enum class severity_level
@@ -108,11 +150,172 @@ namespace ing::logging
         fatal,
     };
 
+    inline constexpr severity_level active_level = static_cast<severity_level>(ING_LOG_ACTIVE_LEVEL);
+
+    constexpr bool active(severity_level level) noexcept
+    {
+        return level >= active_level;
+    }
+
     const char* to_string(severity_level level) noexcept;
     bool from_string(std::string_view str, severity_level& level) noexcept;
     std::ostream& operator<<(std::ostream& os, severity_level level);
     std::istream& operator>>(std::istream& is, severity_level& level);
     severity_level minimum_severity_level(std::string_view channel);
+
+    /**
+     * @brief Entry of the process-wide channel table. Entries are never freed, so that channels are
+     * compared by address and their thresholds are updated in place when reconfigured.
+     */
+    struct interned_channel
+    {
+        std::string_view name;
+        std::uint32_t id;  // in order of interning, the empty channel first
+        mutable std::atomic<severity_level> threshold;
+        // Records of the channel and their message bytes dropped by asynchronous sinks on overflow.
+        mutable std::atomic<std::uint64_t> dropped_records{0};
+        mutable std::atomic<std::uint64_t> dropped_bytes{0};
+    };
+
+    /**
+     * @brief Handle to an interned channel name, copied and compared as a pointer. Interning a name
+     * that is already in the table does not allocate.
+     */
+    class channel_name
+    {
+        const interned_channel* entry;
+
+    public:
+        channel_name() noexcept;
+        channel_name(std::string_view name);
+        channel_name(const char* name) : channel_name(std::string_view(name)) {}
+        channel_name(const std::string& name) : channel_name(std::string_view(name)) {}
+        explicit channel_name(const interned_channel* entry) noexcept : entry(entry) {}
+
+        const interned_channel* handle() const noexcept { return entry; }
+        std::string_view view() const noexcept { return entry->name; }
+        operator std::string_view() const noexcept { return entry->name; }
+
+        friend bool operator==(channel_name a, channel_name b) noexcept { return a.entry == b.entry; }
+        friend bool operator!=(channel_name a, channel_name b) noexcept { return a.entry != b.entry; }
+        friend bool operator<(channel_name a, channel_name b) noexcept { return a.view() < b.view(); }
+        friend bool operator>(channel_name a, channel_name b) noexcept { return a.view() > b.view(); }
+        friend bool operator<=(channel_name a, channel_name b) noexcept { return a.view() <= b.view(); }
+        friend bool operator>=(channel_name a, channel_name b) noexcept { return a.view() >= b.view(); }
+
+        template<typename OStream>
+        friend OStream& operator<<(OStream& os, channel_name channel)
+        {
+            return os << channel.view();
+        }
+
+        friend std::istream& operator>>(std::istream& is, channel_name& channel);
+    };
+
+    std::shared_ptr<std::atomic<severity_level>> channel_threshold(channel_name channel) noexcept;
+
+    /**
+     * @brief Compact identifier of a call site in the process-wide call site table, records carry
+     * it instead of the full source location. The strings of the location must be static.
+     */
+    enum class callsite_id : std::uint32_t {};
+    callsite_id register_callsite(const source_location& loc);
+    const source_location& callsite_location(callsite_id id) noexcept;
+    bool enqueue_record(boost::log::record& rec);
+    bool deferred_formatting() noexcept;
+
+    /**
+     * @brief Incremented by init_logging before and after the swap of the sinks, odd while the core may
+     * route records to nowhere or to the default sink. Loggers open such records again once the swap is done.
+     */
+    inline std::atomic<unsigned> reload_generation{0};
+    void wait_reloaded() noexcept;
+
+    /**
+     * @brief Attach a Message value to the record and return a stream writing into it. The message string
+     * and the stream are recycled through thread-local pools, the stream must be released on the same thread.
+     */
+    boost::log::formatting_ostream& acquire_message_stream(boost::log::record& rec);
+    void release_message_stream(boost::log::formatting_ostream& strm) noexcept;
+}
+
+namespace ing::logging::metrics
+{
+    /**
+     * @brief Set by [Core] Metrics, so that records cost a load otherwise. Counters are sharded per thread
+     * and written by their thread only, the report sums them.
+     */
+    inline std::atomic<bool> collecting{false};
+
+    void count_filtered(const interned_channel* channel, severity_level level) noexcept;
+    void count_emitted(const interned_channel* channel, severity_level level, std::size_t bytes) noexcept;
+
+    /**
+     * @brief Print the metrics tab-separated like ing::timer::report: a line per channel and severity with the
+     * records emitted and filtered by ing loggers and the message bytes formatted by the logging thread, then
+     * a line per configured sink with the records written, the write latency percentiles in microseconds and
+     * the records queued by asynchronous sinks.
+     */
+    void report(std::ostream& os);
+}
+
+namespace ing::logging::sinks
+{
+    /**
+     * @brief Print a tab-separated line per BatchedFile sink with the records, bytes and syscalls written so far,
+     * the records per syscall achieved, and the batches that failed to be written with the records they lost.
+     */
+    void report(std::ostream& os);
+
+    /**
+     * @brief Record decoded from a BinaryFile sink. The views and location strings are valid during the visit only.
+     */
+    struct binary_record
+    {
+        std::optional<std::int64_t> time;  // local time stamp, microseconds since 1970-01-01 00:00:00
+        std::optional<severity_level> severity;
+        std::optional<std::string_view> channel;
+        std::optional<source_location> location;
+        std::string_view message;
+    };
+
+    /**
+     * @brief Visit the records of a file written by BinaryFile sinks in the order they were written, up to the
+     * last record committed. Throw std::invalid_argument if the file is not such a file or is corrupted.
+     */
+    void read_binary_file(const std::string& file, const std::function<void(const binary_record&)>& visit);
+
+    /**
+     * @brief Push the records of a file written by BinaryFile sinks that pass the filter into the core, so that
+     * the configured sinks render them as when they were logged. Return the number of records pushed.
+     */
+    std::size_t replay_binary_file(const std::string& file, const std::function<bool(const binary_record&)>& filter);
+
+    /**
+     * @brief Records looked up in the sidecar index of a BatchedFile sink. Empty fields match any record.
+     */
+    struct index_query
+    {
+        std::optional<std::int64_t> from;  // local time stamp, microseconds since 1970-01-01 00:00:00
+        std::optional<std::int64_t> to;
+        std::optional<severity_level> severity;  // minimum severity
+        std::vector<std::string> channels;  // exact channel names
+    };
+
+    /**
+     * @brief Visit the byte ranges of a file written by a BatchedFile sink that may hold records matching the
+     * query, by looking up its sidecar index FILE.idx. The tail of the file not indexed yet is always visited, as
+     * are the records of a trailing partial entry. Throw std::invalid_argument if the index is missing or is not
+     * an index.
+     */
+    void query_index(const std::string& file, const index_query& query,
+                     const std::function<void(std::uint64_t offset, std::uint64_t size)>& visit);
+}
+
+namespace ing::logging::keywords
+{
+    // std::shared_ptr<std::atomic<LevelT>> shared by loggers and updated on reconfiguration.
+    BOOST_PARAMETER_KEYWORD(tag, threshold)
 }
 
 namespace ing::logging::attributes
@@ -143,10 +346,16 @@ namespace ing::logging::attributes
         struct gen
         {
             using held = Gen;
-            Gen value;
-            Gen& get() noexcept { return value; }
+            Gen generator;
+            Val& value()
+            {
+                // Keeps the generated value alive for references taken by the dispatched callback.
+                static thread_local Val v;
+                return v = generator();
+            }
+            Gen& get() noexcept { return generator; }
             template<typename ...Args>
-            explicit gen(Args&&... args) : value(std::forward<Args>(args)...) {}
+            explicit gen(Args&&... args) : generator(std::forward<Args>(args)...) {}
         };
 
         using holder = std::conditional_t<std::is_invocable_r_v<Val, Gen>, gen, val>;
@@ -205,6 +414,155 @@ namespace ing::logging::attributes
     };
 }
 
+namespace ing::logging
+{
+    /**
+     * @brief Tags of values in binary form, as kept by the flight recorder and as the arguments of deferred
+     * messages stored by BinaryFile sinks. Integers and floating point values follow as 8 bytes, characters and
+     * booleans as 1 byte, strings as a length byte and the characters.
+     */
+    enum argument_tag : unsigned char { signed_tag = 'i', unsigned_tag = 'u', floating_tag = 'f',
+                                        char_tag = 'c', bool_tag = 'b', string_tag = 's', other_tag = '?' };
+}
+
+namespace ing::logging::attributes
+{
+    /**
+     * @brief Format string and arguments of a deferred message, visited by sinks that store them rather than the
+     * formatted message, i.e. BinaryFile.
+     */
+    class deferred_arguments
+    {
+    public:
+        virtual std::string_view format_string() const noexcept = 0;
+        virtual std::string_view suffix_text() const noexcept = 0;
+
+        /**
+         * @brief Append the arguments tagged by argument_tag, false if one of them has no binary form.
+         */
+        virtual bool encode(std::string& out) const = 0;
+
+    protected:
+        ~deferred_arguments() = default;
+    };
+}
+
+#ifdef ING_HAS_FMT
+namespace ing::logging::attributes
+{
+    /**
+     * @brief Message attribute value whose fmt part is formatted on first use, typically by the
+     * asynchronous backend thread. The format string is referenced and the arguments are copied,
+     * text streamed into the record afterwards is appended as is.
+     */
+    template<typename ...Args>
+    class deferred_message : public boost::log::attribute_value::impl, public deferred_arguments
+    {
+        const fmt::string_view format;
+        const std::tuple<Args...> args;
+        const boost::log::attribute_value suffix;
+        spinlock guard;
+        bool formatted = false;
+        std::string message;
+
+        deferred_message(fmt::string_view format, std::tuple<Args...> args, boost::log::attribute_value suffix)
+            : format(format), args(std::move(args)), suffix(std::move(suffix)) {}
+
+        /**
+         * @brief Arithmetic values that fmt formats the same way from their binary form, i.e. not long double,
+         * and char as a character but signed and unsigned char as integers.
+         */
+        template<typename T>
+        static bool encode(std::string& out, const T& t)
+        {
+            auto put = [&out](argument_tag tag, const auto& v)
+            {
+                out.push_back(static_cast<char>(tag));
+                out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+                return true;
+            };
+            if constexpr (std::is_same_v<T, bool>)
+                return put(bool_tag, t);
+            else if constexpr (std::is_same_v<T, char>)
+                return put(char_tag, t);
+            else if constexpr (std::is_integral_v<T> && sizeof(T) <= 8 && std::is_signed_v<T>)
+                return put(signed_tag, static_cast<std::int64_t>(t));
+            else if constexpr (std::is_integral_v<T> && sizeof(T) <= 8)
+                return put(unsigned_tag, static_cast<std::uint64_t>(t));
+            else if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>)
+                return put(floating_tag, static_cast<double>(t));
+            else
+                return false;
+        }
+
+    public:
+        static_assert((std::is_trivially_copyable_v<Args> && ...));
+
+        /**
+         * @brief Replace the message attached by the record pump, which then becomes the suffix.
+         */
+        static void attach(boost::log::record& rec, fmt::string_view format, std::tuple<Args...> args)
+        {
+            auto iter = rec.attribute_values().find(boost::log::aux::default_attribute_names::message());
+            if (iter == rec.attribute_values().end()) return;
+            auto& value = const_cast<boost::log::attribute_value&>(iter->second);
+            boost::log::attribute_value(new deferred_message(format, std::move(args), value)).swap(value);
+        }
+
+        const std::string& get()
+        {
+            std::lock_guard _(guard);
+            if (!formatted)
+            {
+                std::apply([this](const Args&... a) {
+                    fmt::vformat_to(std::back_inserter(message), format, fmt::make_format_args(a...));
+                }, args);
+                if (auto s = suffix.extract<std::string>())
+                    message.append(*s);
+                formatted = true;
+            }
+            return message;
+        }
+
+        std::string_view format_string() const noexcept override
+        {
+            return { format.data(), format.size() };
+        }
+
+        std::string_view suffix_text() const noexcept override
+        {
+            auto s = suffix.extract<std::string>();
+            return s ? std::string_view(*s) : std::string_view();
+        }
+
+        bool encode(std::string& out) const override
+        {
+            return std::apply([&out](const Args&... a) { return (encode(out, a) && ...); }, args);
+        }
+
+        bool dispatch(boost::log::type_dispatcher& dispatcher) override
+        {
+            if (auto callback = dispatcher.get_callback<std::string>())
+            {
+                callback(get());
+                return true;
+            }
+            if (auto callback = dispatcher.get_callback<deferred_arguments>())
+            {
+                callback(*this);
+                return true;
+            }
+            return false;
+        }
+
+        boost::typeindex::type_index get_type() const override
+        {
+            return boost::typeindex::type_id<std::string>();
+        }
+    };
+}
+#endif
+
 namespace ing::logging::sources
 {
     /**
@@ -216,9 +574,35 @@ namespace ing::logging::sources
     class basic_severity_logger : public boost::log::sources::basic_severity_logger<BaseT, LevelT>
     {
         using base_type = boost::log::sources::basic_severity_logger<BaseT, LevelT>;
+        using threshold_type = std::shared_ptr<std::atomic<LevelT>>;
+
+        threshold_type threshold;
 
     public:
-        using base_type::base_type;
+        basic_severity_logger()
+            : threshold(std::make_shared<std::atomic<LevelT>>(base_type::default_severity())) {}
+
+        basic_severity_logger(basic_severity_logger const& that)
+            : base_type(static_cast<base_type const&>(that)), threshold(that.threshold) {}
+
+        basic_severity_logger(basic_severity_logger&& that) noexcept
+            : base_type(std::move(static_cast<base_type&>(that))), threshold(that.threshold) {}
+
+        /**
+         * @brief The threshold is shared with the loggers of the same channel if passed by
+         * ing::logging::keywords::threshold, otherwise it is private and initialized by severity.
+         */
+        template<typename ArgsT>
+        explicit basic_severity_logger(ArgsT const& args)
+            : base_type(args), threshold(args[logging::keywords::threshold | threshold_type()])
+        {
+            if (!threshold) threshold = std::make_shared<std::atomic<LevelT>>(base_type::default_severity());
+        }
+
+        LevelT default_severity() const noexcept
+        {
+            return threshold->load(std::memory_order_relaxed);
+        }
 
     protected:
         template<typename ArgsT>
@@ -228,6 +612,21 @@ namespace ing::logging::sources
                    args[boost::log::keywords::severity | boost::parameter::void_()]);
         }
 
+        void swap_unlocked(basic_severity_logger& that)
+        {
+            base_type::swap_unlocked(static_cast<base_type&>(that));
+            threshold.swap(that.threshold);
+        }
+
+        /**
+         * @brief Follow another shared threshold if the current one is the given shared threshold,
+         * a private threshold is kept.
+         */
+        void rebind_threshold(const std::atomic<LevelT>* current, threshold_type shared) noexcept
+        {
+            if (threshold.get() == current) threshold = std::move(shared);
+        }
+
     private:
         template<typename ArgsT>
         boost::log::record open_record_with_severity_unlocked(ArgsT const& args, LevelT const& level)
@@ -241,6 +640,16 @@ namespace ing::logging::sources
         {
             return {};
         }
+
+    protected:
+        /**
+         * @brief Records are queued to the asynchronous backend if enabled, otherwise pushed to the core directly.
+         */
+        void push_record_unlocked(boost::log::record&& rec)
+        {
+            if (!logging::enqueue_record(rec))
+                base_type::push_record_unlocked(std::move(rec));
+        }
     };
 
     template<typename LevelT>
@@ -260,7 +669,7 @@ namespace ing::logging::sources
     class basic_location_logger : public BaseT
     {
     public:
-        using location_attribute = attributes::thread_specific<LocationT>;
+        using location_attribute = attributes::thread_specific<logging::callsite_id>;
 
     private:
         using base_type = BaseT;
@@ -309,7 +718,10 @@ namespace ing::logging::sources
         template<typename ArgsT, typename T>
         boost::log::record open_record_with_location_unlocked(ArgsT const& args, T const& loc)
         {
-            location.set(loc);
+            if constexpr (std::is_same_v<T, logging::callsite_id>)
+                location.set(loc);
+            else
+                location.set(logging::register_callsite(loc));
             return base_type::open_record_unlocked(args);
         }
 
@@ -358,10 +770,424 @@ namespace ing::logging::sources
         boost::log::record open_record(ArgsT const& args, LocationT location = LocationT::current())
         {
             using base_type = typename basic_severity_channel_location_logger::logger_base;
-            if constexpr(boost::mp11::mp_map_contains<ArgsT, boost::log::keywords::tag::log_source>::value)
-                return base_type::open_record(args);
+            auto open = [&]
+            {
+                if constexpr(boost::mp11::mp_map_contains<ArgsT, boost::log::keywords::tag::log_source>::value)
+                    return base_type::open_record(args);
+                else
+                    return base_type::open_record((args, boost::log::keywords::log_source = location));
+            };
+            for (;;)
+            {
+                auto generation = reload_generation.load(std::memory_order_acquire);
+                if (generation & 1)
+                {
+                    wait_reloaded();
+                    continue;
+                }
+                auto rec = open();
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (reload_generation.load(std::memory_order_relaxed) == generation)
+                    return rec;
+            }
+        }
+    };
+}
+
+namespace ing::logging::sources
+{
+    /** @brief Outcome of a call site policy, streamed as the number of records suppressed since the last one. */
+    struct admission
+    {
+        bool admitted;
+        std::uint64_t suppressed;
+
+        explicit operator bool() const noexcept { return admitted; }
+
+        template<typename OStream>
+        friend OStream& operator<<(OStream& os, const admission& a)
+        {
+            if (a.suppressed) os << '[' << a.suppressed << " suppressed] ";
+            return os;
+        }
+    };
+
+    /** @brief Admit the first record and every n-th one after it. */
+    class every_n
+    {
+        const std::uint64_t n;
+        std::atomic<std::uint64_t> count{0};
+
+    public:
+        explicit every_n(std::uint64_t n) noexcept : n(n ? n : 1) {}
+
+        admission admit() noexcept
+        {
+            std::uint64_t c = count.fetch_add(1, std::memory_order_relaxed);
+            if (c % n) return { false, 0 };
+            return { true, c ? n - 1 : 0 };
+        }
+    };
+
+    namespace rates
+    {
+        struct rate { double per_second; };
+        struct period { double seconds; };
+
+        inline constexpr period s{1}, min{60}, h{3600};
+
+        constexpr rate operator/(double n, period p) noexcept { return { n / p.seconds }; }
+    }
+
+    /** @brief Token bucket admitting records at a sustained rate with bursts up to the bucket size. */
+    class rate_limit
+    {
+        using clock = std::chrono::steady_clock;
+
+        const std::int64_t interval;    // nanoseconds per token
+        const std::int64_t tolerance;   // nanoseconds of burst allowance
+        std::atomic<std::int64_t> tat;  // theoretical arrival time of the next token
+        std::atomic<std::uint64_t> suppressed{0};
+
+        static std::int64_t now() noexcept
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now().time_since_epoch()).count();
+        }
+
+    public:
+        explicit rate_limit(rates::rate r, double burst = 0) noexcept
+            : interval(r.per_second > 0 ? static_cast<std::int64_t>(1e9 / r.per_second) : INT64_MAX / 2)
+            , tolerance(static_cast<std::int64_t>(((burst > 0 ? burst : r.per_second > 1 ? r.per_second : 1) - 1) * interval))
+            , tat(now())
+        {
+        }
+
+        admission admit() noexcept
+        {
+            std::int64_t t = now();
+            std::int64_t expected = tat.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                std::int64_t next = (expected > t ? expected : t);
+                if (next - t > tolerance)
+                {
+                    suppressed.fetch_add(1, std::memory_order_relaxed);
+                    return { false, 0 };
+                }
+                if (tat.compare_exchange_weak(expected, next + interval, std::memory_order_relaxed))
+                    break;
+            }
+            return { true, suppressed.exchange(0, std::memory_order_relaxed) };
+        }
+    };
+
+    /** @brief Admit each record independently with the given probability. */
+    class sample
+    {
+        const std::uint64_t threshold;
+        std::atomic<std::uint64_t> suppressed{0};
+
+        static std::uint64_t next() noexcept
+        {
+            // splitmix64 seeded by the address of the thread local state
+            thread_local std::uint64_t state = reinterpret_cast<std::uintptr_t>(&state);
+            std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+    public:
+        explicit sample(double probability) noexcept
+            : threshold(probability >= 1 ? UINT64_MAX : probability <= 0 ? 0
+                        : static_cast<std::uint64_t>(probability * 18446744073709551616.0))
+        {
+        }
+
+        admission admit() noexcept
+        {
+            if (threshold != UINT64_MAX && next() >= threshold)
+            {
+                suppressed.fetch_add(1, std::memory_order_relaxed);
+                return { false, 0 };
+            }
+            return { true, suppressed.exchange(0, std::memory_order_relaxed) };
+        }
+    };
+}
+
+namespace ing::logging
+{
+    /**
+     * @brief Stream-style writer of the message of an open record. Characters, strings and arithmetic values
+     * are appended to the message directly, formatted as the stream would in the classic locale. Other values,
+     * and all values once formatting flags or a field width are set, go through the formatting stream.
+     */
+    class record_writer
+    {
+        boost::log::formatting_ostream* strm = nullptr;
+        std::string* text = nullptr;
+        bool buffered = false;  // the stream may hold characters not yet in the text
+        bool exposed = false;   // the stream was handed out, so it may be written at any time
+
+        template<typename T>
+        static constexpr bool is_char = std::is_same_v<T, char> ||
+                                        std::is_same_v<T, signed char> ||
+                                        std::is_same_v<T, unsigned char>;
+
+        template<typename T>
+        static constexpr bool is_number = std::is_arithmetic_v<T> && !std::is_same_v<T, bool> && !is_char<T> &&
+                                          !std::is_same_v<T, wchar_t> && !std::is_same_v<T, char16_t> &&
+#ifdef __cpp_char8_t
+                                          !std::is_same_v<T, char8_t> &&
+#endif
+                                          !std::is_same_v<T, char32_t>;
+
+        bool plain() const noexcept
+        {
+            return strm->flags() == (std::ios_base::dec | std::ios_base::skipws) && strm->width() == 0;
+        }
+
+        std::string& sync()
+        {
+            if (buffered)
+            {
+                strm->rdbuf()->pubsync();
+                buffered = exposed;
+            }
+            return *text;
+        }
+
+        template<typename T, typename ...Args>
+        bool append_chars(T value, Args... args)
+        {
+            char buf[std::is_integral_v<T> ? 48 : 64];
+            auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), value, args...);
+            if (ec != std::errc()) return false;
+            sync().append(buf, end);
+            return true;
+        }
+
+        template<typename T>
+        bool append(const T& t)
+        {
+            if constexpr (is_char<T>)
+                return plain() && (sync().push_back(static_cast<char>(t)), true);
+            else if constexpr (std::is_same_v<T, bool>)
+                return plain() && (sync().push_back(t ? '1' : '0'), true);
+            else if constexpr (is_number<T> && std::is_integral_v<T>)
+                return plain() && append_chars(t);
+#if __cpp_lib_to_chars >= 201611L
+            else if constexpr (is_number<T>)
+                return plain() && append_chars(t, std::chars_format::general, static_cast<int>(strm->precision()));
+#endif
+            else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>)
+                return strm->width() == 0 && (sync().append(t.data(), t.size()), true);
+            else if constexpr (std::is_array_v<T> && std::is_same_v<std::remove_cv_t<std::remove_extent_t<T>>, char>)
+                return strm->width() == 0 && (sync().append(t), true);
+            else if constexpr (std::is_same_v<std::decay_t<T>, const char*> || std::is_same_v<std::decay_t<T>, char*>)
+                return t && strm->width() == 0 && (sync().append(t), true);
             else
-                return base_type::open_record((args, boost::log::keywords::log_source = location));
+                return false;
+        }
+
+    public:
+        record_writer() noexcept = default;
+
+        explicit record_writer(boost::log::record& rec)
+            : strm(rec ? &acquire_message_stream(rec) : nullptr), text(strm ? strm->rdbuf()->storage() : nullptr)
+        {
+        }
+
+        record_writer(const record_writer&) = delete;
+        record_writer& operator=(const record_writer&) = delete;
+        ~record_writer() { close(); }
+
+        /**
+         * @brief Completes the message and releases the stream, must be called before pushing the record.
+         */
+        void close() noexcept
+        {
+            if (strm) release_message_stream(*strm);
+            strm = nullptr;
+        }
+
+        std::ostream& stream() noexcept
+        {
+            buffered = exposed = true;
+            return strm->stream();
+        }
+
+        /**
+         * @brief Size of the message once closed.
+         */
+        std::size_t size() const noexcept
+        {
+            return text ? text->size() : 0;
+        }
+
+#ifdef ING_HAS_FMT
+        /**
+         * @brief Formats into the message through a back inserter, which fmt and std::format both write in
+         * bulk to contiguous containers.
+         */
+        void vformat(fmt::string_view format, fmt::format_args args)
+        {
+            fmt::vformat_to(std::back_inserter(sync()), format, args);
+        }
+#endif
+
+        template<typename T>
+        record_writer& operator<<(const T& t)
+        {
+            if (!append(t))
+            {
+                *strm << t;
+                buffered = true;
+            }
+            return *this;
+        }
+
+        record_writer& operator<<(std::ios_base& (*manip)(std::ios_base&))
+        {
+            *strm << manip;
+            return *this;
+        }
+
+        record_writer& operator<<(std::ios& (*manip)(std::ios&))
+        {
+            *strm << manip;
+            return *this;
+        }
+
+        record_writer& operator<<(std::ostream& (*manip)(std::ostream&))
+        {
+            *strm << manip;
+            buffered = true;
+            return *this;
+        }
+    };
+
+    /**
+     * @brief Fixed-size binary record of the flight recorder. The payload is a sequence of tagged values,
+     * the slot is valid once its sequence number is set.
+     */
+    struct flight_slot
+    {
+        std::atomic<std::uint64_t> sequence;
+        std::int64_t time;  // microseconds since the system clock epoch
+        const interned_channel* channel;
+        callsite_id callsite;
+        severity_level severity;
+        std::uint16_t size;
+        bool truncated;
+        unsigned char payload[128 - 32];
+    };
+
+    /**
+     * @brief Set while the flight recorder is enabled, so that suppressed records cost a load otherwise.
+     */
+    inline std::atomic<bool> flight_recording{false};
+
+    flight_slot* flight_begin(severity_level level, const interned_channel* channel,
+                              callsite_id id, std::uint64_t& sequence) noexcept;
+    flight_slot* flight_begin(severity_level level, const interned_channel* channel,
+                              const source_location& loc, std::uint64_t& sequence) noexcept;
+
+    /**
+     * @brief Push the records kept by the flight recorder of all threads into the sinks, oldest first.
+     */
+    void dump_flight_recorder();
+
+    /**
+     * @brief Writer of a record suppressed by the threshold into the flight recorder of the thread.
+     * Arithmetic values and strings are copied in binary form, other values are recorded as a placeholder,
+     * formatting manipulators are ignored. Values beyond the slot capacity are dropped.
+     */
+    class flight_writer
+    {
+        std::uint64_t sequence = 0;  // set by flight_begin, so declared before the slot
+        flight_slot* slot = nullptr;
+
+        void put(argument_tag tag, const void* data, std::size_t n) noexcept
+        {
+            if (slot->size + 1 + n > sizeof(slot->payload))
+            {
+                slot->truncated = true;
+                return;
+            }
+            auto* p = slot->payload + slot->size;
+            *p = tag;
+            std::memcpy(p + 1, data, n);
+            slot->size = static_cast<std::uint16_t>(slot->size + 1 + n);
+        }
+
+        void put(std::string_view s) noexcept
+        {
+            std::size_t room = sizeof(slot->payload) - slot->size;
+            if (room < 3 || s.size() > room - 2)
+            {
+                slot->truncated = true;
+                if (room < 3) return;
+                s = s.substr(0, room - 2);
+            }
+            auto* p = slot->payload + slot->size;
+            p[0] = string_tag;
+            p[1] = static_cast<unsigned char>(s.size());
+            std::memcpy(p + 2, s.data(), s.size());
+            slot->size = static_cast<std::uint16_t>(slot->size + 2 + s.size());
+        }
+
+    public:
+        flight_writer() noexcept = default;
+
+        template<typename Location>
+        flight_writer(severity_level level, const interned_channel* channel, const Location& loc) noexcept
+            : slot(flight_recording.load(std::memory_order_relaxed) ? flight_begin(level, channel, loc, sequence) : nullptr)
+        {
+        }
+
+        flight_writer(const flight_writer&) = delete;
+        flight_writer& operator=(const flight_writer&) = delete;
+
+        ~flight_writer()
+        {
+            if (slot) slot->sequence.store(sequence, std::memory_order_release);
+        }
+
+        explicit operator bool() const noexcept { return slot != nullptr; }
+
+        template<typename T>
+        flight_writer& operator<<(const T& t) noexcept
+        {
+            if constexpr (std::is_same_v<T, bool>)
+                put(bool_tag, &t, 1);
+            else if constexpr (std::is_same_v<T, char> || std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char>)
+                put(char_tag, &t, 1);
+            else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+            {
+                std::int64_t v = t;
+                put(signed_tag, &v, sizeof(v));
+            }
+            else if constexpr (std::is_integral_v<T>)
+            {
+                std::uint64_t v = t;
+                put(unsigned_tag, &v, sizeof(v));
+            }
+            else if constexpr (std::is_floating_point_v<T>)
+            {
+                double v = static_cast<double>(t);
+                put(floating_tag, &v, sizeof(v));
+            }
+            else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>)
+                put(std::string_view(t));
+            else if constexpr (std::is_array_v<T> && std::is_same_v<std::remove_cv_t<std::remove_extent_t<T>>, char>)
+                put(std::string_view(t));
+            else if constexpr (std::is_same_v<std::decay_t<T>, const char*> || std::is_same_v<std::decay_t<T>, char*>)
+                put(t ? std::string_view(t) : std::string_view());
+            else if constexpr (!std::is_invocable_v<T, std::ios_base&>)
+                put(other_tag, nullptr, 0);
+            return *this;
         }
     };
 }
@@ -370,63 +1196,114 @@ namespace ing
 {
     template<typename ThreadingModelT>
     class basic_logger : public logging::sources::basic_severity_channel_location_logger<
-            char, ThreadingModelT, logging::severity_level, std::string, source_location>
+            char, ThreadingModelT, logging::severity_level, logging::channel_name, source_location>
     {
         class helper
         {
             friend basic_logger;
-            using base = boost::log::aux::record_pump<basic_logger>;
             boost::log::record record;
-            union { base pump; };
+            basic_logger* logger = nullptr;
+            logging::record_writer writer;
+            logging::flight_writer flight;
+            int exceptions = 0;
+            logging::severity_level level = logging::severity_level::trace;
+
+            helper() noexcept {}
+
+            helper(basic_logger& lg, logging::severity_level level, boost::log::record rec)
+                : record(std::move(rec)), logger(&lg), writer(record),
+                  exceptions(record ? std::uncaught_exceptions() : 0), level(level)
+            {
+                if (!record && logging::metrics::collecting.load(std::memory_order_relaxed))
+                    logging::metrics::count_filtered(lg.channel_handle, level);
+            }
 
-            helper(basic_logger& lg, boost::log::record rec)
-                : record(std::move(rec))
+            /**
+             * @brief Record suppressed by the threshold, kept by the flight recorder if enabled. The format string
+             * of a fmt record is kept without its arguments.
+             */
+            template<typename Location>
+            helper(basic_logger& lg, logging::severity_level level, const Location& loc, std::string_view text = {})
+                : flight(level, lg.channel_handle, loc)
             {
-                if (record) new ((void*)std::addressof(pump)) base(lg, record);
+                if (logging::metrics::collecting.load(std::memory_order_relaxed))
+                    logging::metrics::count_filtered(lg.channel_handle, level);
+                if (flight && !text.empty()) flight << text;
             }
 
 #ifdef ING_HAS_FMT
-            helper(basic_logger& lg, boost::log::record rec,
+            helper(basic_logger& lg, logging::severity_level level, boost::log::record rec,
                    fmt::string_view fmt, fmt::format_args args)
-                    : helper(lg, std::move(rec))
+                    : helper(lg, level, std::move(rec))
             {
-                if (record) fmt::vformat_to(std::ostreambuf_iterator<char>(stream()), fmt, args);
+                if (record) writer.vformat(fmt, args);
+            }
+
+            template<typename ...Args>
+            helper(basic_logger& lg, logging::severity_level level, boost::log::record rec,
+                   fmt::string_view fmt, std::tuple<Args...> args)
+                    : helper(lg, level, std::move(rec))
+            {
+                if (record) logging::attributes::deferred_message<Args...>::attach(record, fmt, std::move(args));
             }
 #endif
 
         public:
             helper(const helper&) = delete;
             helper& operator=(const helper&) = delete;
-            ~helper() noexcept(false) { if (record) pump.~base(); }
-            explicit operator bool() const noexcept { return !!record; }
-            std::ostream& stream() noexcept { return pump.stream().stream(); }
+            ~helper() noexcept(false)
+            {
+                if (!record) return;
+                writer.close();
+                // Like boost::log::aux::record_pump, the record is dropped if the statement is left by an exception.
+                if (std::uncaught_exceptions() <= exceptions)
+                {
+                    if (logging::metrics::collecting.load(std::memory_order_relaxed))
+                        logging::metrics::count_emitted(logger->channel_handle, level, writer.size());
+                    logger->push_record(std::move(record));
+                }
+            }
+
+            /**
+             * @brief Whether the record is open or kept by the flight recorder, i.e. whether operands are used.
+             */
+            explicit operator bool() const noexcept { return record || flight; }
+            std::ostream& stream() noexcept { return writer.stream(); }
+
+            /**
+             * @brief The helper itself, ending the logging macros so that a statement without operands has an effect.
+             */
+            helper& self() noexcept { return *this; }
 
             template<typename T>
             helper& operator<<(const T& t)
             {
-                if (record) pump.stream() << t;
+                if (record) writer << t;
+                else if (flight) flight << t;
                 return *this;
             }
 
             helper& operator<<(std::ios_base& (*manip)(std::ios_base&))
             {
-                if (record) pump.stream() << manip;
+                if (record) writer << manip;
                 return *this;
             }
 
             helper& operator<<(std::ios& (*manip)(std::ios&))
             {
-                if (record) pump.stream() << manip;
+                if (record) writer << manip;
                 return *this;
             }
 
             helper& operator<<(std::ostream& (*manip)(std::ostream&))
             {
-                if (record) pump.stream() << manip;
+                if (record) writer << manip;
                 return *this;
             }
         };
 
+        const logging::interned_channel* channel_handle;
+
     public:
         using logger_base = typename basic_logger::final_type;
         using typename logger_base::severity_level;
@@ -434,18 +1311,27 @@ namespace ing
         template<typename ...Args>
         basic_logger(typename logger_base::channel_type channel,
                      severity_level min_level, Args&&... args)
-            : logger_base(boost::log::keywords::channel = std::move(channel),
+            : logger_base(boost::log::keywords::channel = channel,
                           boost::log::keywords::severity = min_level,
-                          std::forward<Args>(args)...) {}
+                          std::forward<Args>(args)...), channel_handle(channel.handle()) {}
 
         template<typename ...Args>
         explicit basic_logger(typename logger_base::channel_type channel, Args&&... args)
-            : basic_logger(std::move(channel), logging::minimum_severity_level(channel),
-                           std::forward<Args>(args)...) {}
+            : logger_base(logging::keywords::threshold = logging::channel_threshold(channel),
+                          boost::log::keywords::channel = channel,
+                          std::forward<Args>(args)...), channel_handle(channel.handle()) {}
+
+        /**
+         * @brief Returns a helper without record, i.e. the call site is eliminated at compile time.
+         */
+        static auto inactive() noexcept
+        {
+            return helper();
+        }
 
         bool enabled(severity_level level) const noexcept
         {
-            return level >= this->default_severity();
+            return logging::active(level) && level >= this->default_severity();
         }
 
         bool is_trace_enabled() const noexcept
@@ -478,9 +1364,34 @@ namespace ing
             return enabled(severity_level::fatal);
         }
 
+        using logger_base::channel;
+
+        /**
+         * @brief Switch the channel, the threshold follows the new channel unless pinned by an explicit level.
+         */
+        void channel(const typename logger_base::channel_type& ch)
+        {
+            logger_base::channel(ch);
+            this->rebind_threshold(&channel_handle->threshold, logging::channel_threshold(ch));
+            channel_handle = ch.handle();
+        }
+
         auto log(severity_level level, source_location loc = source_location::current())
         {
-            return helper(*this, this->open_record(boost::log::keywords::severity = level, loc));
+            if (!logging::active(level)) return helper();
+            if (level < this->default_severity()) return helper(*this, level, loc);
+            return helper(*this, level, this->open_record(boost::log::keywords::severity = level, loc));
+        }
+
+        /**
+         * @brief Used by the logging macros, which register their call site once.
+         */
+        auto log(severity_level level, logging::callsite_id id)
+        {
+            if (!logging::active(level)) return helper();
+            if (level < this->default_severity()) return helper(*this, level, id);
+            return helper(*this, level, this->open_record((boost::log::keywords::severity = level,
+                                                    boost::log::keywords::log_source = id)));
         }
 
         auto trace(source_location loc = source_location::current())
@@ -519,7 +1430,9 @@ namespace ing
                  fmt::format_args args,
                  source_location loc = source_location::current())
         {
-            return helper(*this, this->open_record(boost::log::keywords::severity = level, loc), fmt, args);
+            if (!logging::active(level)) return helper();
+            if (level < this->default_severity()) return helper(*this, level, loc, std::string_view(fmt.data(), fmt.size()));
+            return helper(*this, level, this->open_record(boost::log::keywords::severity = level, loc), fmt, args);
         }
 
         auto trace(fmt::string_view fmt,
@@ -567,43 +1480,53 @@ namespace ing
         template<typename ...Args>
         auto log(severity_level level, fmt::fmtloc_t<Args...> fmtloc, Args&&... args)
         {
+            if (!logging::active(level)) return helper();
+#if defined(__cpp_consteval)
+            // The format string of a consteval format_location is a constant, so it outlives the record.
+            if constexpr (fmt::is_deferrable_v<Args...>)
+            {
+                if (logging::deferred_formatting() && level >= this->default_severity())
+                    return helper(*this, level, this->open_record(boost::log::keywords::severity = level, fmtloc.location),
+                                  fmtloc.get(), std::tuple<std::decay_t<Args>...>(args...));
+            }
+#endif
             return log(level, fmtloc.get(), fmt::make_format_args(args...), fmtloc.location);
         }
 
         template<typename ...Args>
         auto trace(fmt::fmtloc_t<Args...> fmtloc, Args&&... args)
         {
-            return trace(fmtloc.get(), fmt::make_format_args(args...), fmtloc.location);
+            return log<Args...>(severity_level::trace, fmtloc, std::forward<Args>(args)...);
         }
 
         template<typename ...Args>
         auto debug(fmt::fmtloc_t<Args...> fmtloc, Args&&... args)
         {
-            return debug(fmtloc.get(), fmt::make_format_args(args...), fmtloc.location);
+            return log<Args...>(severity_level::debug, fmtloc, std::forward<Args>(args)...);
         }
 
         template<typename ...Args>
         auto info(fmt::fmtloc_t<Args...> fmtloc, Args&&... args)
         {
-            return info(fmtloc.get(), fmt::make_format_args(args...), fmtloc.location);
+            return log<Args...>(severity_level::info, fmtloc, std::forward<Args>(args)...);
         }
 
         template<typename ...Args>
         auto warn(fmt::fmtloc_t<Args...> fmtloc, Args&&... args)
         {
-            return warn(fmtloc.get(), fmt::make_format_args(args...), fmtloc.location);
+            return log<Args...>(severity_level::warn, fmtloc, std::forward<Args>(args)...);
         }
 
         template<typename ...Args>
         auto error(fmt::fmtloc_t<Args...> fmtloc, Args&&... args)
         {
-            return error(fmtloc.get(), fmt::make_format_args(args...), fmtloc.location);
+            return log<Args...>(severity_level::error, fmtloc, std::forward<Args>(args)...);
         }
 
         template<typename ...Args>
         auto fatal(fmt::fmtloc_t<Args...> fmtloc, Args&&... args)
         {
-            return fatal(fmtloc.get(), fmt::make_format_args(args...), fmtloc.location);
+            return log<Args...>(severity_level::fatal, fmtloc, std::forward<Args>(args)...);
         }
 #endif
     };
@@ -615,72 +1538,79 @@ namespace ing
 
     inline bool enabled(logging::severity_level level) noexcept
     {
-        return global_logger::get().enabled(level);
+        return logging::active(level) && global_logger::get().enabled(level);
     }
 
     inline bool is_trace_enabled() noexcept
     {
-        return global_logger::get().is_trace_enabled();
+        return logging::active(logging::severity_level::trace) && global_logger::get().is_trace_enabled();
     }
 
     inline bool is_debug_enabled() noexcept
     {
-        return global_logger::get().is_debug_enabled();
+        return logging::active(logging::severity_level::debug) && global_logger::get().is_debug_enabled();
     }
 
     inline bool is_info_enabled() noexcept
     {
-        return global_logger::get().is_info_enabled();
+        return logging::active(logging::severity_level::info) && global_logger::get().is_info_enabled();
     }
 
     inline bool is_warn_enabled() noexcept
     {
-        return global_logger::get().is_warn_enabled();
+        return logging::active(logging::severity_level::warn) && global_logger::get().is_warn_enabled();
     }
 
     inline bool is_error_enabled() noexcept
     {
-        return global_logger::get().is_error_enabled();
+        return logging::active(logging::severity_level::error) && global_logger::get().is_error_enabled();
     }
 
     inline bool is_fatal_enabled() noexcept
     {
-        return global_logger::get().is_fatal_enabled();
+        return logging::active(logging::severity_level::fatal) && global_logger::get().is_fatal_enabled();
     }
 
     inline auto log(logging::severity_level level, source_location loc = source_location::current())
     {
+        if (!logging::active(level)) return logger_mt::inactive();
         return global_logger::get().log(level, loc);
     }
 
     inline auto trace(source_location loc = source_location::current())
     {
-        return global_logger::get().trace(loc);
+        if constexpr (!logging::active(logging::severity_level::trace)) return logger_mt::inactive();
+        else return global_logger::get().trace(loc);
     }
 
     inline auto debug(source_location loc = source_location::current())
     {
-        return global_logger::get().debug(loc);
+        if constexpr (!logging::active(logging::severity_level::debug)) return logger_mt::inactive();
+        else return global_logger::get().debug(loc);
     }
 
     inline auto info(source_location loc = source_location::current())
     {
-        return global_logger::get().info(loc);
+        if constexpr (!logging::active(logging::severity_level::info)) return logger_mt::inactive();
+        else return global_logger::get().info(loc);
     }
 
     inline auto warn(source_location loc = source_location::current())
     {
-        return global_logger::get().warn(loc);
+        if constexpr (!logging::active(logging::severity_level::warn)) return logger_mt::inactive();
+        else return global_logger::get().warn(loc);
     }
 
     inline auto error(source_location loc = source_location::current())
     {
-        return global_logger::get().error(loc);
+        if constexpr (!logging::active(logging::severity_level::error)) return logger_mt::inactive();
+        else return global_logger::get().error(loc);
     }
 
     inline auto fatal(source_location loc = source_location::current())
     {
-        return global_logger::get().fatal(loc);
+        if constexpr (!logging::active(logging::severity_level::fatal)) return logger_mt::inactive();
+        else return global_logger::get().fatal(loc);
     }
 
 #ifdef ING_HAS_FMT
@@ -689,6 +1619,7 @@ namespace ing
                     fmt::format_args args,
                     source_location loc = source_location::current())
     {
+        if (!logging::active(level)) return logger_mt::inactive();
         return global_logger::get().log(level, fmt, args, loc);
     }
 
@@ -696,106 +1627,158 @@ namespace ing
                       fmt::format_args args,
                       source_location loc = source_location::current())
     {
-        return global_logger::get().trace(fmt, args, loc);
+        if constexpr (!logging::active(logging::severity_level::trace)) return logger_mt::inactive();
+        else return global_logger::get().trace(fmt, args, loc);
     }
 
     inline auto debug(fmt::string_view fmt,
                       fmt::format_args args,
                       source_location loc = source_location::current())
     {
-        return global_logger::get().debug(fmt, args, loc);
+        if constexpr (!logging::active(logging::severity_level::debug)) return logger_mt::inactive();
+        else return global_logger::get().debug(fmt, args, loc);
     }
 
     inline auto info(fmt::string_view fmt,
                      fmt::format_args args,
                      source_location loc = source_location::current())
     {
-        return global_logger::get().info(fmt, args, loc);
+        if constexpr (!logging::active(logging::severity_level::info)) return logger_mt::inactive();
+        else return global_logger::get().info(fmt, args, loc);
     }
 
     inline auto warn(fmt::string_view fmt,
                      fmt::format_args args,
                      source_location loc = source_location::current())
     {
-        return global_logger::get().warn(fmt, args, loc);
+        if constexpr (!logging::active(logging::severity_level::warn)) return logger_mt::inactive();
+        else return global_logger::get().warn(fmt, args, loc);
     }
 
     inline auto error(fmt::string_view fmt,
                       fmt::format_args args,
                       source_location loc = source_location::current())
     {
-        return global_logger::get().error(fmt, args, loc);
+        if constexpr (!logging::active(logging::severity_level::error)) return logger_mt::inactive();
+        else return global_logger::get().error(fmt, args, loc);
     }
 
     inline auto fatal(fmt::string_view fmt,
                       fmt::format_args args,
                       source_location loc = source_location::current())
     {
-        return global_logger::get().fatal(fmt, args, loc);
+        if constexpr (!logging::active(logging::severity_level::fatal)) return logger_mt::inactive();
+        else return global_logger::get().fatal(fmt, args, loc);
     }
 
     template<typename ...Args>
     auto log(logging::severity_level level, fmt::fmtloc_t<Args...> fmtloc, Args&&... args)
     {
+        if (!logging::active(level)) return logger_mt::inactive();
         return global_logger::get().log(level, fmtloc, std::forward<Args>(args)...);
     }
 
     template<typename ...Args>
     auto trace(fmt::fmtloc_t<Args...> fmtloc, Args&&... args)
     {
-        return global_logger::get().trace(fmtloc, std::forward<Args>(args)...);
+        if constexpr (!logging::active(logging::severity_level::trace)) return logger_mt::inactive();
+        else return global_logger::get().trace(fmtloc, std::forward<Args>(args)...);
     }
 
     template<typename ...Args>
     auto debug(fmt::fmtloc_t<Args...> fmtloc, Args&&... args)
     {
-        return global_logger::get().debug(fmtloc, std::forward<Args>(args)...);
+        if constexpr (!logging::active(logging::severity_level::debug)) return logger_mt::inactive();
+        else return global_logger::get().debug(fmtloc, std::forward<Args>(args)...);
     }
 
     template<typename ...Args>
     auto info(fmt::fmtloc_t<Args...> fmtloc, Args&&... args)
     {
-        return global_logger::get().info(fmtloc, std::forward<Args>(args)...);
+        if constexpr (!logging::active(logging::severity_level::info)) return logger_mt::inactive();
+        else return global_logger::get().info(fmtloc, std::forward<Args>(args)...);
     }
 
     template<typename ...Args>
     auto warn(fmt::fmtloc_t<Args...> fmtloc, Args&&... args)
     {
-        return global_logger::get().warn(fmtloc, std::forward<Args>(args)...);
+        if constexpr (!logging::active(logging::severity_level::warn)) return logger_mt::inactive();
+        else return global_logger::get().warn(fmtloc, std::forward<Args>(args)...);
     }
 
     template<typename ...Args>
     auto error(fmt::fmtloc_t<Args...> fmtloc, Args&&... args)
     {
-        return global_logger::get().error(fmtloc, std::forward<Args>(args)...);
+        if constexpr (!logging::active(logging::severity_level::error)) return logger_mt::inactive();
+        else return global_logger::get().error(fmtloc, std::forward<Args>(args)...);
     }
 
     template<typename ...Args>
     auto fatal(fmt::fmtloc_t<Args...> fmtloc, Args&&... args)
     {
-        return global_logger::get().fatal(fmtloc, std::forward<Args>(args)...);
+        if constexpr (!logging::active(logging::severity_level::fatal)) return logger_mt::inactive();
+        else return global_logger::get().fatal(fmtloc, std::forward<Args>(args)...);
     }
 #endif
 
     void init_logging(const std::string& file = {});
     void init_logging_from_stream(std::istream& in);
     void init_logging_from_settings(/*boost::log::settings*/void const * settings);
+    void flush_logging();
 }
 
+// Discard the statement at compile time if the static severity is below ING_LOG_ACTIVE_LEVEL
+#define ING_LOG_ACTIVE(sev) if constexpr (!::ing::logging::active(::ing::logging::severity_level::sev)) {} else
+
+// Identifier of the current call site, registered once per macro expansion
+#define ING_CALLSITE() [](const ::ing::source_location& loc) { \
+                           static const auto id = ::ing::logging::register_callsite(loc); \
+                           return id; \
+                       }(ING_CURRENT_LOCATION())
+
 // Generic logging macro with specified logger instance and dynamic severity
-#define ING_LOG_SEV(logger, sev) BOOST_LOG_STREAM_WITH_PARAMS((logger), \
-                                 (::boost::log::keywords::severity = (sev)) \
-                                 (::boost::log::keywords::log_source = ING_CURRENT_LOCATION()))
+// Operands are evaluated only if the record is open or kept by the flight recorder
+#define ING_LOG_SEV(logger, sev) if (!::ing::logging::active(sev)) {} else \
+                                 if (auto ing_helper = (logger).log((sev), ING_CALLSITE()); !ing_helper) {} else \
+                                     ing_helper.self()
 
 // Generic logging macro with specified logger instance and static severity
-#define ING_LOG(logger, sev) ING_LOG_SEV((logger), ::ing::logging::severity_level::sev)
+#define ING_LOG(logger, sev) ING_LOG_ACTIVE(sev) ING_LOG_SEV((logger), ::ing::logging::severity_level::sev)
+
+
+// Call site policy object, constructed once per macro expansion from constant arguments
+#define ING_LOG_POLICY(policy, ...) [] { \
+                                        using namespace ::ing::logging::sources::rates; \
+                                        static ::ing::logging::sources::policy p(__VA_ARGS__); \
+                                        return &p; \
+                                    }()
+
+// Generic logging macro gated by a call site policy, prefixing the number of records suppressed by it
+#define ING_LOG_ADMIT(logger, sev, policy) ING_LOG_ACTIVE(sev) \
+                                           if (!(logger).enabled(::ing::logging::severity_level::sev)) {} else \
+                                           if (auto ing_admission = (policy)->admit(); !ing_admission) {} else \
+                                           ING_LOG_SEV((logger), ::ing::logging::severity_level::sev) << ing_admission
+
+// Log the first record and every n-th one after it
+#define ING_LOG_EVERY_N(logger, sev, n) ING_LOG_ADMIT(logger, sev, ING_LOG_POLICY(every_n, (n)))
+
+// Log at most the given rate, e.g. 10/s, with bursts up to one second worth of records
+#define ING_LOG_RATE(logger, sev, rate) ING_LOG_ADMIT(logger, sev, ING_LOG_POLICY(rate_limit, (rate)))
+
+// Log each record with the given probability
+#define ING_LOG_SAMPLE(logger, sev, p) ING_LOG_ADMIT(logger, sev, ING_LOG_POLICY(sample, (p)))
 
 
 // Global logging macro with dynamic severity
 #define ING_GLOG_SEV(sev) ING_LOG_SEV(::ing::global_logger::get(), (sev))
 
 // Global logging macro with static severity
-#define ING_GLOG(sev) ING_GLOG_SEV(::ing::logging::severity_level::sev)
+#define ING_GLOG(sev) ING_LOG_ACTIVE(sev) ING_GLOG_SEV(::ing::logging::severity_level::sev)
+
+// Global logging macros gated by a call site policy
+#define ING_GLOG_EVERY_N(sev, n) ING_LOG_EVERY_N(::ing::global_logger::get(), sev, n)
+#define ING_GLOG_RATE(sev, rate) ING_LOG_RATE(::ing::global_logger::get(), sev, rate)
+#define ING_GLOG_SAMPLE(sev, p) ING_LOG_SAMPLE(::ing::global_logger::get(), sev, p)
 
 
 #ifndef ING_LOCAL_LOGGER
@@ -806,7 +1789,12 @@ namespace ing
 #define ING_LLOG_SEV(sev) ING_LOG_SEV((ING_LOCAL_LOGGER), (sev))
 
 // Local logging macro with static severity
-#define ING_LLOG(sev) ING_LLOG_SEV(::ing::logging::severity_level::sev)
+#define ING_LLOG(sev) ING_LOG_ACTIVE(sev) ING_LLOG_SEV(::ing::logging::severity_level::sev)
+
+// Local logging macros gated by a call site policy
+#define ING_LLOG_EVERY_N(sev, n) ING_LOG_EVERY_N((ING_LOCAL_LOGGER), sev, n)
+#define ING_LLOG_RATE(sev, rate) ING_LOG_RATE((ING_LOCAL_LOGGER), sev, rate)
+#define ING_LLOG_SAMPLE(sev, p) ING_LOG_SAMPLE((ING_LOCAL_LOGGER), sev, p)
 
 
 #endif
@@ -40,6 +40,12 @@ namespace ing
         void swap(basic_string& other) noexcept { return string_base::swap(other); }
     };
 
+    template<typename CharT, typename Traits, typename OStream>
+    OStream& operator<<(OStream& os, const basic_string<CharT, Traits>& s)
+    {
+        return os << s.view();
+    }
+
     using string = basic_string<char>;
     using wstring = basic_string<wchar_t>;
     using u16string = basic_string<char16_t>;
@@ -2,6 +2,7 @@
 
 #include <boost/log/detail/default_attribute_names.hpp>
 #include <boost/log/attributes/clock.hpp>
+#include <boost/log/attributes/constant.hpp>
 #include <boost/log/attributes/named_scope.hpp>
 #include <boost/log/attributes/current_thread_id.hpp>
 #include <boost/log/attributes/current_process_id.hpp>
@@ -17,14 +18,74 @@
 #include <boost/log/expressions/formatters/auto_newline.hpp>
 #include <boost/log/expressions/formatters/wrap_formatter.hpp>
 
+#include <boost/log/sinks/async_frontend.hpp>
+#include <boost/log/sinks/basic_sink_backend.hpp>
+#include <boost/log/sinks/sync_frontend.hpp>
+#include <boost/log/sinks/text_file_backend.hpp>
+#include <boost/log/sinks/text_ostream_backend.hpp>
 #include <boost/log/support/date_time.hpp>
 #include <boost/log/utility/setup/console.hpp>
 #include <boost/log/utility/setup/from_settings.hpp>
 #include <boost/log/utility/setup/settings_parser.hpp>
 #include <boost/log/utility/setup/formatter_parser.hpp>
+#include <boost/log/utility/setup/filter_parser.hpp>
 
+#include <boost/core/null_deleter.hpp>
+#include <boost/io/ios_state.hpp>
+#include <boost/smart_ptr/weak_ptr.hpp>
+
+#include <ing/spinlock.hpp>
+#include <ing/threading.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
 #include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <regex>
+#include <set>
+#include <shared_mutex>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ING_LOGGING_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
 
 
 namespace ing::logging
@@ -96,16 +157,506 @@ namespace ing::logging
     }
 
 
-    static std::vector<std::pair<severity_level, std::regex>> thresholds;
+    /**
+     * @brief [Thresholds] compiled for lookup by channel. Literal patterns are matched exactly, a literal
+     * followed by ".*" by prefix, and the rest fall back to std::regex. The first matching entry in
+     * declaration order wins. Results are memoized per channel until the matcher is replaced.
+     */
+    class threshold_matcher
+    {
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+        static constexpr std::size_t cache_limit = 4096;
+
+        std::vector<severity_level> levels;
+        std::map<std::string, std::size_t, std::less<>> exact;
+        std::map<std::string, std::size_t, std::less<>> prefix;
+        std::vector<std::size_t> prefix_sizes;
+        std::vector<std::pair<std::size_t, std::regex>> regexes;
+
+        mutable std::shared_mutex cache_guard;
+        mutable std::map<std::string, severity_level, std::less<>> cache;
+
+        static bool literal(std::string_view pattern, std::string& str)
+        {
+            for (std::size_t i = 0; i < pattern.size(); ++i)
+            {
+                char c = pattern[i];
+                if (c == '\\')
+                {
+                    if (++i == pattern.size() || std::isalnum(static_cast<unsigned char>(pattern[i])))
+                        return false;
+                    c = pattern[i];
+                }
+                else if (std::strchr("^$.*+?()[]{}|", c))
+                {
+                    return false;
+                }
+                str.push_back(c);
+            }
+            return true;
+        }
+
+        severity_level match(std::string_view channel) const
+        {
+            std::size_t best = npos;
+
+            if (auto iter = exact.find(channel); iter != exact.end())
+                best = iter->second;
+
+            for (auto size : prefix_sizes)
+            {
+                if (size > channel.size()) break;
+                if (auto iter = prefix.find(channel.substr(0, size)); iter != prefix.end())
+                    best = std::min(best, iter->second);
+            }
+
+            for (const auto& entry : regexes)
+            {
+                if (entry.first > best) break;
+                if (std::regex_match(channel.begin(), channel.end(), entry.second))
+                {
+                    best = entry.first;
+                    break;
+                }
+            }
+
+            return best == npos ? severity_level::trace : levels[best];
+        }
+
+    public:
+        void add(severity_level level, std::string_view pattern)
+        {
+            auto index = levels.size();
+            levels.push_back(level);
+
+            std::string str;
+            if (literal(pattern, str))
+            {
+                exact.emplace(std::move(str), index);
+            }
+            else if (pattern.size() >= 2 && pattern.substr(pattern.size() - 2) == ".*" &&
+                     literal(pattern.substr(0, pattern.size() - 2), str = {}))
+            {
+                auto iter = std::lower_bound(prefix_sizes.begin(), prefix_sizes.end(), str.size());
+                if (iter == prefix_sizes.end() || *iter != str.size())
+                    prefix_sizes.insert(iter, str.size());
+                prefix.emplace(std::move(str), index);
+            }
+            else
+            {
+                regexes.emplace_back(index, std::regex(pattern.begin(), pattern.end()));
+            }
+        }
+
+        severity_level operator()(std::string_view channel) const
+        {
+            {
+                std::shared_lock _(cache_guard);
+                if (auto iter = cache.find(channel); iter != cache.end())
+                    return iter->second;
+            }
+
+            auto level = match(channel);
+            std::unique_lock _(cache_guard);
+            if (cache.size() >= cache_limit) cache.clear();
+            cache.emplace(channel, level);
+            return level;
+        }
+    };
+
+    static spinlock thresholds_guard;
+    static std::shared_ptr<const threshold_matcher> thresholds = std::make_shared<threshold_matcher>();
 
     severity_level minimum_severity_level(std::string_view channel)
     {
-        for (const auto& entry : thresholds)
+        std::shared_ptr<const threshold_matcher> matcher;
+        {
+            std::lock_guard _(thresholds_guard);
+            matcher = thresholds;
+        }
+        return (*matcher)(channel);
+    }
+
+    /**
+     * @brief Interned channel names. The thresholds of all interned channels are updated in place when
+     * the thresholds are reconfigured, so loggers of a channel share its threshold without reference counting.
+     */
+    class channel_table
+    {
+        std::shared_mutex guard;
+        std::unordered_map<std::string_view, const interned_channel*> index;
+
+        channel_table()
+        {
+            index.emplace(empty.name, &empty);
+        }
+
+    public:
+        static inline interned_channel empty{ {}, 0, { severity_level::trace } };
+
+        static channel_table& get()
+        {
+            // Never destroyed, as channel names are used by loggers with static storage duration.
+            static channel_table& table = *new channel_table;
+            return table;
+        }
+
+        const interned_channel* intern(std::string_view name)
+        {
+            {
+                std::shared_lock _(guard);
+                if (auto iter = index.find(name); iter != index.end())
+                    return iter->second;
+            }
+
+            std::lock_guard _(guard);
+            if (auto iter = index.find(name); iter != index.end())
+                return iter->second;
+
+            auto* storage = new char[name.size()];
+            std::memcpy(storage, name.data(), name.size());
+            std::string_view key(storage, name.size());
+            auto id = static_cast<std::uint32_t>(index.size());
+            auto* entry = new interned_channel{ key, id, { minimum_severity_level(key) } };
+            index.emplace(key, entry);
+            return entry;
+        }
+
+        /**
+         * @brief All interned channels, by id.
+         */
+        std::vector<const interned_channel*> channels()
+        {
+            std::vector<const interned_channel*> result;
+            {
+                std::shared_lock _(guard);
+                result.reserve(index.size());
+                for (const auto& entry : index)
+                    result.push_back(entry.second);
+            }
+            std::sort(result.begin(), result.end(), [](auto a, auto b) { return a->id < b->id; });
+            return result;
+        }
+
+        void update(std::shared_ptr<const threshold_matcher> matcher)
+        {
+            std::lock_guard _(guard);
+            {
+                std::lock_guard _(thresholds_guard);
+                thresholds.swap(matcher);
+                matcher = thresholds;
+            }
+            for (const auto& entry : index)
+                entry.second->threshold.store((*matcher)(entry.first), std::memory_order_relaxed);
+        }
+    };
+
+    channel_name::channel_name() noexcept : entry(&channel_table::empty) {}
+
+    channel_name::channel_name(std::string_view name) : entry(channel_table::get().intern(name)) {}
+
+    std::istream& operator>>(std::istream& is, channel_name& channel)
+    {
+        std::string name;
+        if (is >> name) channel = channel_name(name);
+        return is;
+    }
+
+    std::shared_ptr<std::atomic<severity_level>> channel_threshold(channel_name channel) noexcept
+    {
+        // Aliases the never freed entry without owning it, so that copies do not count references.
+        return { std::shared_ptr<void>(), &channel.handle()->threshold };
+    }
+
+
+    /**
+     * @brief Append-only table of call sites. Entries are stored in chunks which are never moved,
+     * so that lookup by identifier is lock free. Identifier 0 is an unknown location.
+     */
+    class callsite_table
+    {
+        static constexpr std::size_t chunk_bits = 10;
+        static constexpr std::size_t chunk_size = std::size_t(1) << chunk_bits;
+        static constexpr std::size_t chunk_count = 4096;
+
+        using key = std::tuple<const char*, const char*, std::uint_least32_t, std::uint_least32_t>;
+
+        std::atomic<source_location*> chunks[chunk_count] = {};
+        std::mutex guard;
+        std::map<key, callsite_id> index;
+
+        callsite_table()
+        {
+            add(source_location{});
+        }
+
+    public:
+        static callsite_table& get()
+        {
+            // Never destroyed, as records may still be formatted at exit.
+            static callsite_table& table = *new callsite_table;
+            return table;
+        }
+
+        callsite_id add(const source_location& loc)
+        {
+            std::lock_guard _(guard);
+            auto k = key(loc.file_name(), loc.function_name(), loc.line(), loc.column());
+            if (auto iter = index.find(k); iter != index.end())
+                return iter->second;
+
+            auto n = index.size();
+            if (n >= chunk_size * chunk_count) return callsite_id{};
+            auto* chunk = chunks[n >> chunk_bits].load(std::memory_order_relaxed);
+            if (!chunk)
+            {
+                chunk = new source_location[chunk_size];
+                chunks[n >> chunk_bits].store(chunk, std::memory_order_release);
+            }
+            chunk[n & (chunk_size - 1)] = loc;
+            return index.emplace(k, static_cast<callsite_id>(n)).first->second;
+        }
+
+        const source_location& operator[](callsite_id id) const noexcept
+        {
+            auto n = static_cast<std::size_t>(id);
+            return chunks[n >> chunk_bits].load(std::memory_order_acquire)[n & (chunk_size - 1)];
+        }
+    };
+
+    callsite_id register_callsite(const source_location& loc)
+    {
+        // Call sites passing source_location at runtime hit a small direct-mapped cache per thread.
+        struct entry
+        {
+            const char* file;
+            const char* function;
+            std::uint_least32_t line;
+            std::uint_least32_t column;
+            callsite_id id;
+        };
+
+        static thread_local entry cache[256];
+        auto h = reinterpret_cast<std::uintptr_t>(loc.file_name()) ^ (loc.line() * 0x9E3779B1u) ^ loc.column();
+        auto& e = cache[(h ^ (h >> 8)) & 255];
+        if (e.file != loc.file_name() || e.function != loc.function_name() ||
+            e.line != loc.line() || e.column != loc.column())
+        {
+            e = { loc.file_name(), loc.function_name(), loc.line(), loc.column(), callsite_table::get().add(loc) };
+        }
+        return e.id;
+    }
+
+    const source_location& callsite_location(callsite_id id) noexcept
+    {
+        return callsite_table::get()[id];
+    }
+}
+
+namespace ing::logging
+{
+    struct message_slot;
+
+    /**
+     * @brief Message value living in a pooled slot together with its string, both returned to the pool
+     * when the last record referring to it is destroyed.
+     */
+    class message_buffer final : public boost::log::attribute_value::impl
+    {
+        std::string& text;
+
+        explicit message_buffer(std::string& text) noexcept : text(text) {}
+
+    public:
+        static message_buffer* create();
+        static void* operator new(std::size_t size) = delete;
+        static void operator delete(void* p) noexcept;
+
+        std::string& str() noexcept { return text; }
+
+        bool dispatch(boost::log::type_dispatcher& dispatcher) override
+        {
+            if (auto callback = dispatcher.get_callback<std::string>())
+            {
+                callback(text);
+                return true;
+            }
+            return false;
+        }
+
+        boost::intrusive_ptr<boost::log::attribute_value::impl> detach_from_thread() override
+        {
+            // The text is not modified once the record is pushed, so it can be shared by any thread.
+            return this;
+        }
+
+        boost::typeindex::type_index get_type() const override
+        {
+            return boost::typeindex::type_id<std::string>();
+        }
+    };
+
+    struct message_slot
+    {
+        alignas(message_buffer) unsigned char storage[sizeof(message_buffer)];
+        std::string text;
+        message_slot* next = nullptr;
+    };
+
+    /**
+     * @brief Free list of message slots per thread, spilling into and refilling from a shared list,
+     * as records are often destroyed on another thread than the one making them.
+     */
+    class message_pool
+    {
+        static constexpr std::size_t local_limit = 64;
+        static constexpr std::size_t reserve = 256;
+        static constexpr std::size_t retain = 64 * 1024;  // larger buffers are freed instead of recycled
+
+        struct local_list
+        {
+            message_slot* head = nullptr;
+            std::size_t size = 0;
+
+            ~local_list()
+            {
+                exited = true;
+                while (head)
+                {
+                    auto* s = head;
+                    head = s->next;
+                    release_shared(s);
+                }
+            }
+        };
+
+        static inline spinlock guard;
+        static inline message_slot* shared = nullptr;
+        static inline thread_local bool exited = false;
+
+        static local_list& local() noexcept
+        {
+            static thread_local local_list list;
+            return list;
+        }
+
+        static void release_shared(message_slot* s) noexcept
+        {
+            std::lock_guard _(guard);
+            s->next = shared;
+            shared = s;
+        }
+
+    public:
+        static message_slot* acquire()
+        {
+            if (!exited)
+            {
+                auto& list = local();
+                if (list.head)
+                {
+                    auto* s = list.head;
+                    list.head = s->next;
+                    --list.size;
+                    return s;
+                }
+            }
+            {
+                std::lock_guard _(guard);
+                if (auto* s = shared)
+                {
+                    shared = s->next;
+                    return s;
+                }
+            }
+            auto* s = new message_slot;
+            s->text.reserve(reserve);
+            return s;
+        }
+
+        static void release(message_slot* s) noexcept
+        {
+            s->text.clear();
+            if (s->text.capacity() > retain)
+                std::string().swap(s->text);
+
+            if (!exited)
+            {
+                auto& list = local();
+                if (list.size < local_limit)
+                {
+                    s->next = list.head;
+                    list.head = s;
+                    ++list.size;
+                    return;
+                }
+            }
+            release_shared(s);
+        }
+    };
+
+    message_buffer* message_buffer::create()
+    {
+        auto* s = message_pool::acquire();
+        return ::new (static_cast<void*>(s->storage)) message_buffer(s->text);
+    }
+
+    void message_buffer::operator delete(void* p) noexcept
+    {
+        message_pool::release(reinterpret_cast<message_slot*>(p));
+    }
+
+    /**
+     * @brief Formatting streams of the thread, reused by nested statements in LIFO order.
+     */
+    struct stream_pool
+    {
+        std::vector<std::unique_ptr<boost::log::formatting_ostream>> streams;
+
+        static stream_pool& local() noexcept
+        {
+            static thread_local stream_pool pool;
+            return pool;
+        }
+    };
+
+    boost::log::formatting_ostream& acquire_message_stream(boost::log::record& rec)
+    {
+        auto* buffer = message_buffer::create();
+        boost::log::attribute_value value(buffer);
+        auto result = rec.attribute_values().insert(boost::log::aux::default_attribute_names::message(), value);
+        if (!result.second)
+            const_cast<boost::log::attribute_value&>(result.first->second).swap(value);
+
+        auto& streams = stream_pool::local().streams;
+        boost::log::formatting_ostream* strm;
+        if (streams.empty())
+        {
+            // Reserved up front, so that releasing the stream never allocates.
+            streams.reserve(streams.capacity() + 1);
+            strm = new boost::log::formatting_ostream;
+        }
+        else
         {
-            if (std::regex_match(channel.begin(), channel.end(), entry.second))
-                return entry.first;
+            strm = streams.back().release();
+            streams.pop_back();
         }
-        return severity_level::trace;
+
+        strm->exceptions(std::ios_base::goodbit);
+        strm->clear();
+        strm->flags(std::ios_base::dec | std::ios_base::skipws);
+        strm->width(0);
+        strm->precision(6);
+        strm->fill(' ');
+        strm->attach(buffer->str());
+        return *strm;
+    }
+
+    void release_message_stream(boost::log::formatting_ostream& strm) noexcept
+    {
+        strm.flush();
+        strm.detach();
+        stream_pool::local().streams.emplace_back(&strm);
     }
 }
 
@@ -113,7 +664,66 @@ namespace ing::logging::attributes
 {
     using namespace boost::log::attributes;
 
-    using current_thread_name = thread_specific<std::string>;
+    /**
+     * @brief Name set by ing::set_thread_name, shared by reference count so that detaching does not copy it.
+     */
+    using current_thread_name = thread_specific<ing::string, ing::string(*)()>;
+
+    /**
+     * @brief Local clock converting to local time once per second per thread and adding the sub-second part,
+     * instead of a full local time conversion per record as local_clock does.
+     */
+    class cached_local_clock : public boost::log::attribute
+    {
+        class impl final : public boost::log::attribute::impl
+        {
+        public:
+            boost::log::attribute_value get_value() override
+            {
+                return boost::log::attributes::make_attribute_value(now());
+            }
+        };
+
+    public:
+        using value_type = boost::posix_time::ptime;
+
+        cached_local_clock() : boost::log::attribute(new impl) {}
+        explicit cached_local_clock(cast_source const& source) : boost::log::attribute(source.as<impl>()) {}
+
+        static value_type now()
+        {
+            using namespace boost::posix_time;
+            struct cache
+            {
+                std::time_t second = -1;
+                ptime local;
+            };
+            static thread_local cache c;
+
+            auto now = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+            auto second = static_cast<std::time_t>(now / 1000000);
+            if (second != c.second)
+            {
+                std::tm tm;
+#ifdef _WIN32
+                localtime_s(&tm, &second);
+#else
+                localtime_r(&second, &tm);
+#endif
+                c.second = second;
+                c.local = ptime(boost::gregorian::date_from_tm(tm), time_duration(tm.tm_hour, tm.tm_min, tm.tm_sec));
+            }
+            return c.local + microseconds(now % 1000000);
+        }
+    };
+
+    /**
+     * @brief Attributes evaluated only when a value is dispatched to a sink or detached from the thread,
+     * registered in place of the eager ones for attributes no configured sink references.
+     */
+    using lazy_local_clock = thread_specific<cached_local_clock::value_type, cached_local_clock::value_type(*)()>;
+    using lazy_named_scope = thread_specific<named_scope::value_type, named_scope::value_type(*)()>;
 }
 
 namespace ing::logging::expressions
@@ -140,7 +750,7 @@ namespace ing::logging::expressions
     BOOST_LOG_ATTRIBUTE_KEYWORD(severity, ::ing::logging::expressions::names::severity(), ::ing::logger_mt::severity_attribute::value_type)
     BOOST_LOG_ATTRIBUTE_KEYWORD(channel, ::ing::logging::expressions::names::channel(), ::ing::logger_mt::channel_attribute::value_type)
     BOOST_LOG_ATTRIBUTE_KEYWORD(location, ::ing::logging::expressions::names::line_id(), ::ing::logger_mt::location_attribute::value_type)
-    BOOST_LOG_ATTRIBUTE_KEYWORD(timestamp, ::ing::logging::expressions::names::timestamp(), ::ing::logging::attributes::local_clock::value_type)
+    BOOST_LOG_ATTRIBUTE_KEYWORD(timestamp, ::ing::logging::expressions::names::timestamp(), ::ing::logging::attributes::cached_local_clock::value_type)
     BOOST_LOG_ATTRIBUTE_KEYWORD(thread_id, ::ing::logging::expressions::names::thread_id(), ::ing::logging::attributes::current_thread_id::value_type)
     BOOST_LOG_ATTRIBUTE_KEYWORD(process_id, ::ing::logging::expressions::names::process_id(), ::ing::logging::attributes::current_process_id::value_type)
     BOOST_LOG_ATTRIBUTE_KEYWORD(thread_name, ::ing::logging::expressions::names::thread_name(), ::ing::logging::attributes::current_thread_name::value_type)
@@ -148,104 +758,3222 @@ namespace ing::logging::expressions
     BOOST_LOG_ATTRIBUTE_KEYWORD(scope, ::ing::logging::expressions::names::scope(), ::ing::logging::attributes::named_scope::value_type)
 
 
+    /**
+     * @brief Text rendered once per call site and published lock free, in chunks indexed like callsite_table.
+     */
+    class callsite_text_cache
+    {
+        static constexpr std::size_t chunk_bits = 10;
+        static constexpr std::size_t chunk_size = std::size_t(1) << chunk_bits;
+        static constexpr std::size_t chunk_count = 4096;
+
+        using entry = std::atomic<const std::string*>;
+
+        std::atomic<entry*> chunks[chunk_count] = {};
+
+    public:
+        callsite_text_cache() = default;
+        callsite_text_cache(const callsite_text_cache&) = delete;
+        callsite_text_cache& operator=(const callsite_text_cache&) = delete;
+
+        ~callsite_text_cache()
+        {
+            for (auto& chunk : chunks)
+            {
+                auto* p = chunk.load(std::memory_order_relaxed);
+                if (!p) continue;
+                for (std::size_t i = 0; i < chunk_size; ++i)
+                    delete p[i].load(std::memory_order_relaxed);
+                delete[] p;
+            }
+        }
+
+        template<typename Render>
+        const std::string& get(callsite_id id, Render&& render)
+        {
+            auto n = static_cast<std::size_t>(id);
+            if (n >= chunk_size * chunk_count) n = 0;
+
+            auto& chunk = chunks[n >> chunk_bits];
+            auto* p = chunk.load(std::memory_order_acquire);
+            if (!p)
+            {
+                auto* fresh = new entry[chunk_size]();
+                if (chunk.compare_exchange_strong(p, fresh, std::memory_order_acq_rel)) p = fresh;
+                else delete[] fresh;
+            }
+
+            auto& e = p[n & (chunk_size - 1)];
+            auto* text = e.load(std::memory_order_acquire);
+            if (!text)
+            {
+                auto* fresh = new std::string(render());
+                if (e.compare_exchange_strong(text, fresh, std::memory_order_acq_rel)) text = fresh;
+                else delete fresh;
+            }
+            return *text;
+        }
+    };
+
+    /**
+     * @brief Source location formatter rendering the named scope format once per call site.
+     */
     template<typename Keyword>
     auto format_source_location(const Keyword& keyword, std::string_view format)
     {
+        auto formatter = boost::log::expressions::aux::parse_named_scope_format(format.data(), format.data() + format.size());
+        auto cache = std::make_shared<callsite_text_cache>();
+
         return boost::log::expressions::wrap_formatter(
-        [keyword, formatter = boost::log::expressions::aux::parse_named_scope_format(format.data(), format.data() + format.size())]
-        (boost::log::record_view const& rec, boost::log::formatting_ostream& strm)
+        [keyword, formatter, cache](boost::log::record_view const& rec, boost::log::formatting_ostream& strm)
         {
-            if (const auto& loc = rec[keyword])
+            if (const auto& id = rec[keyword])
             {
-                struct unbox
-                {
-                    boost::log::string_literal::const_iterator str;
-                    boost::log::string_literal::size_type len;
+                const auto& text = cache->get(*id, [&formatter, id = *id] {
+                    const auto& loc = callsite_location(id);
+                    struct unbox
+                    {
+                        boost::log::string_literal::const_iterator str;
+                        boost::log::string_literal::size_type len;
+
+                        void operator=(const char* s)
+                        {
+                            static_assert(sizeof(unbox) == sizeof(boost::log::string_literal));
+
+                            str = s;
+                            len = boost::log::string_literal::traits_type::length(s);
+                        }
+                    };
+
+                    using scope_entry = attributes::named_scope::scope_entry;
+                    scope_entry entry({}, {}, loc.line(), scope_entry::function);
+                    reinterpret_cast<unbox&>(entry.scope_name) = loc.function_name();
+                    reinterpret_cast<unbox&>(entry.file_name) = loc.file_name();
+
+                    std::string str;
+                    boost::log::formatting_ostream os(str);
+                    formatter(os, entry);
+                    os.flush();
+                    return str;
+                });
+                strm.write(text.data(), static_cast<std::streamsize>(text.size()));
+            }
+        });
+    }
+
+    /**
+     * @brief Timestamp formatter rendering the format once per second and patching only the sub-second digits.
+     * Formats whose rendering does not split into fixed width sub-second digits fall back to format_date_time.
+     */
+    template<typename Keyword>
+    auto format_timestamp(const Keyword& keyword, const std::string& format)
+    {
+        using value_type = typename Keyword::value_type;
+        using traits = boost::log::expressions::aux::date_time_formatter_generator_traits<value_type, char>;
+        using tick_traits = typename value_type::time_duration_type::traits_type;
+        constexpr int digits = 6;
+
+        struct layout
+        {
+            typename traits::formatter_function_type formatter;
+            std::uint64_t id;  // never reused, identifies the formatter in the caches of the threads
+
+            std::string render(const value_type& t) const
+            {
+                std::string str;
+                boost::log::formatting_ostream strm(str);
+                formatter(strm, t);
+                strm.flush();
+                return str;
+            }
+        };
+
+        // Rendering of the current second, kept per thread so that the threads formatting records do not contend.
+        struct cache
+        {
+            std::uint64_t id = 0;
+            value_type second = value_type(boost::posix_time::not_a_date_time);
+            std::string text;               // rendered for the current second
+            std::vector<std::size_t> runs;  // offsets of the sub-second digit runs in text
+            bool fixed = true;
+
+            void update(const layout& l, const value_type& t)
+            {
+                second = value_type(t.date(), boost::posix_time::seconds(t.time_of_day().total_seconds()));
+                text = l.render(second);
+                auto last = l.render(second + typename value_type::time_duration_type(0, 0, 0, tick_traits::ticks_per_second - 1));
+                runs.clear();
+                fixed = text.size() == last.size();
+                for (std::size_t i = 0; fixed && i < text.size(); ++i)
+                {
+                    if (text[i] == last[i]) continue;
+                    fixed = i + digits <= text.size() && text.compare(i, digits, "000000") == 0
+                            && last.compare(i, digits, "999999") == 0;
+                    runs.push_back(i);
+                    i += digits - 1;
+                }
+            }
+        };
+
+        static std::atomic<std::uint64_t> ids{0};
+        auto l = std::make_shared<layout>();
+        l->formatter = traits::parse(format);
+        l->id = ids.fetch_add(1, std::memory_order_relaxed) + 1;
+
+        return boost::log::expressions::wrap_formatter(
+        [keyword, l](boost::log::record_view const& rec, boost::log::formatting_ostream& strm)
+        {
+            const auto& t = rec[keyword];
+            if (!t) return;
+            if (t->is_special()) return l->formatter(strm, *t);
+
+            // A thread formats with a few formatters at a time, the least recently added cache is replaced.
+            static thread_local std::array<cache, 4> caches;
+            static thread_local std::size_t replaced = 0;
+            cache* c = nullptr;
+            for (auto& e : caches)
+            {
+                if (e.id != l->id) continue;
+                c = &e;
+                break;
+            }
+            if (!c)
+            {
+                c = &caches[replaced++ % caches.size()];
+                c->id = l->id;
+                c->second = value_type(boost::posix_time::not_a_date_time);
+            }
+
+            auto offset = (*t - c->second).ticks();
+            if (c->second.is_special() || offset < 0 || offset >= tick_traits::ticks_per_second)
+            {
+                c->update(*l, *t);
+                offset = (*t - c->second).ticks();
+            }
+            if (!c->fixed) return l->formatter(strm, *t);
+
+            std::uint64_t frac = static_cast<std::uint64_t>(offset);
+            if constexpr (tick_traits::ticks_per_second > 1000000) frac /= tick_traits::ticks_per_second / 1000000;
+            else frac *= 1000000 / tick_traits::ticks_per_second;
+
+            // Patch the sub-second digits in place, the text of the current second is otherwise unchanged
+            for (auto run : c->runs)
+            {
+                auto f = frac;
+                for (int i = digits; i-- > 0; f /= 10) c->text[run + i] = static_cast<char>('0' + f % 10);
+            }
+            strm.write(c->text.data(), static_cast<std::streamsize>(c->text.size()));
+        });
+    }
+
+    const auto reset_sgr = boost::phoenix::val("\033[39;49m");
+
+    template<typename Keyword, std::size_t N>
+    auto sgr(const Keyword& keyword, const std::array<std::string, N>& table)
+    {
+        return boost::log::expressions::wrap_formatter(
+            [keyword, table](boost::log::record_view const& rec, boost::log::formatting_ostream& strm)
+            {
+                if (const auto& level = rec[keyword])
+                {
+                    auto i = static_cast<int>(*level);
+                    if (i >= 0 && i < table.size() && !table[i].empty())
+                        strm << '\033' << '[' << table[i] << 'm';
+                }
+            });
+    }
+
+    /**
+     * @brief Find the next ESC in [p, end), scanning 16 bytes at a time where SSE2 is available.
+     */
+    inline char* find_escape(char* p, char* end) noexcept
+    {
+#ifdef ING_LOGGING_SSE2
+        const __m128i esc = _mm_set1_epi8('\033');
+        for (; end - p >= 16; p += 16)
+        {
+            auto mask = static_cast<unsigned>(_mm_movemask_epi8(
+                    _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), esc)));
+            if (mask)
+            {
+#ifdef _MSC_VER
+                unsigned long i;
+                _BitScanForward(&i, mask);
+                return p + i;
+#else
+                return p + __builtin_ctz(mask);
+#endif
+            }
+        }
+        for (; p != end; ++p)
+            if (*p == '\033') return p;
+        return end;
+#else
+        auto q = static_cast<char*>(std::memchr(p, '\033', static_cast<std::size_t>(end - p)));
+        return q ? q : end;
+#endif
+    }
+
+    const auto strip_sgr = boost::log::expressions::wrap_formatter(
+        [](boost::log::record_view const&, boost::log::formatting_ostream& strm)
+        {
+            strm.flush();
+
+            if (std::string* s = strm.rdbuf()->storage())
+            {
+                char* const end = s->data() + s->size();
+                char* r = find_escape(s->data(), end);
+                if (r == end) return;
+
+                // Compact in a single pass, moving the text between complete ESC [ <digits;> m sequences
+                char* w = r;
+                while (r != end)
+                {
+                    char* q = r + 1;
+                    if (q != end && *q == '[')
+                    {
+                        ++q;
+                        while (q != end && (('0' <= *q && *q <= '9') || *q == ';')) ++q;
+                    }
+                    if (q != end && *q == 'm' && q - r >= 2)
+                        r = q + 1;
+                    else
+                        *w++ = *r++;
+
+                    char* next = find_escape(r, end);
+                    if (w != r) std::memmove(w, r, static_cast<std::size_t>(next - r));
+                    w += next - r;
+                    r = next;
+                }
+                s->resize(static_cast<std::size_t>(w - s->data()));
+            }
+        });
+}
+
+namespace ing::logging::async
+{
+    /**
+     * @brief Single-producer/single-consumer ring of records. Every producer thread owns one ring
+     * per dispatcher generation, and only the backend thread consumes from it.
+     */
+    class ring
+    {
+        const std::size_t mask;
+        const std::unique_ptr<boost::log::record[]> slots;
+        alignas(64) std::atomic<std::size_t> head{0};
+        alignas(64) std::atomic<std::size_t> tail{0};
+
+    public:
+        const std::size_t generation;
+        std::atomic<bool> orphaned{false};
+
+        ring(std::size_t capacity, std::size_t generation)
+            : mask(capacity - 1), slots(new boost::log::record[capacity]), generation(generation) {}
+
+        bool empty() const noexcept
+        {
+            return head.load(std::memory_order_relaxed) == tail.load(std::memory_order_acquire);
+        }
+
+        bool push(boost::log::record& rec) noexcept
+        {
+            auto t = tail.load(std::memory_order_relaxed);
+            if (t - head.load(std::memory_order_acquire) > mask) return false;
+            slots[t & mask] = std::move(rec);
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool pop(boost::log::record& rec) noexcept
+        {
+            auto h = head.load(std::memory_order_relaxed);
+            if (h == tail.load(std::memory_order_acquire)) return false;
+            rec = std::move(slots[h & mask]);
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+    };
+
+    /**
+     * @brief Moves records from the producer threads to a dedicated backend thread which pushes them
+     * into the core, so that formatting and sink I/O are paid by the backend thread only.
+     */
+    class dispatcher
+    {
+        struct producer
+        {
+            std::shared_ptr<ring> current;
+            ~producer() { if (current) current->orphaned.store(true, std::memory_order_release); }
+        };
+
+        static inline thread_local producer local;
+
+        boost::log::core_ptr core;
+        std::thread backend;
+        std::thread::id backend_id;
+        std::atomic<std::size_t> capacity{0};
+        std::atomic<std::size_t> generation{0};
+        std::atomic<bool> running{false};
+        std::atomic<bool> stopping{false};
+        std::atomic<std::size_t> pushing{0};  // producers between their check of running and their push
+        std::atomic<bool> deferring{false};
+
+        spinlock rings_guard;
+        std::vector<std::shared_ptr<ring>> rings;
+        std::atomic<std::size_t> rings_version{0};
+
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        std::condition_variable flushed;
+        std::atomic<bool> sleeping{false};
+        std::atomic<std::size_t> flush_requested{0};
+        std::atomic<std::size_t> flush_completed{0};
+
+        ring& local_ring()
+        {
+            auto& r = local.current;
+            auto gen = generation.load(std::memory_order_acquire);
+            if (!r || r->generation != gen)
+            {
+                if (r) r->orphaned.store(true, std::memory_order_release);
+                r = std::make_shared<ring>(capacity.load(std::memory_order_relaxed), gen);
+                std::lock_guard _(rings_guard);
+                rings.push_back(r);
+                rings_version.fetch_add(1, std::memory_order_release);
+            }
+            return *r;
+        }
+
+        void wake()
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (sleeping.load(std::memory_order_relaxed))
+            {
+                std::lock_guard _(mutex);
+                wakeup.notify_one();
+            }
+        }
+
+        bool pending()
+        {
+            if (stopping.load(std::memory_order_acquire)) return true;
+            if (flush_requested.load(std::memory_order_acquire) != flush_completed.load(std::memory_order_relaxed)) return true;
+            std::lock_guard _(rings_guard);
+            for (const auto& r : rings)
+                if (!r->empty()) return true;
+            return false;
+        }
+
+        std::size_t drain(std::vector<std::shared_ptr<ring>>& snapshot, std::size_t& version)
+        {
+            if (auto v = rings_version.load(std::memory_order_acquire); v != version)
+            {
+                std::lock_guard _(rings_guard);
+                snapshot = rings;
+                version = v;
+            }
+
+            std::size_t n = 0;
+            bool prune = false;
+            boost::log::record rec;
+            for (const auto& r : snapshot)
+            {
+                // Orphaned flag must be observed before the last pop to not lose records.
+                bool orphaned = r->orphaned.load(std::memory_order_acquire);
+                while (r->pop(rec))
+                {
+                    core->push_record(std::move(rec));
+                    ++n;
+                }
+                if (orphaned) prune = true;
+            }
+
+            if (prune)
+            {
+                std::lock_guard _(rings_guard);
+                rings.erase(std::remove_if(rings.begin(), rings.end(), [](const std::shared_ptr<ring>& r) {
+                    return r->orphaned.load(std::memory_order_acquire) && r->empty();
+                }), rings.end());
+                rings_version.fetch_add(1, std::memory_order_release);
+            }
+            return n;
+        }
+
+        void run()
+        {
+            set_thread_name("ing-logging");
+
+            std::vector<std::shared_ptr<ring>> snapshot;
+            std::size_t version = static_cast<std::size_t>(-1);
+            while (true)
+            {
+                auto ticket = flush_requested.load(std::memory_order_acquire);
+                bool stop = stopping.load(std::memory_order_acquire);
+                auto n = drain(snapshot, version);
+
+                if (ticket != flush_completed.load(std::memory_order_relaxed))
+                {
+                    core->flush();
+                    std::lock_guard _(mutex);
+                    flush_completed.store(ticket, std::memory_order_release);
+                    flushed.notify_all();
+                }
+
+                if (stop) break;
+                if (n > 0) continue;
+
+                std::unique_lock lock(mutex);
+                sleeping.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                wakeup.wait(lock, [this] { return pending(); });
+                sleeping.store(false, std::memory_order_relaxed);
+            }
+        }
+
+    public:
+        ~dispatcher() { stop(); }
+
+        bool enabled() const noexcept
+        {
+            return running.load(std::memory_order_acquire);
+        }
+
+        bool deferred() const noexcept
+        {
+            return deferring.load(std::memory_order_relaxed);
+        }
+
+        bool configured(std::size_t ring_capacity, bool defer) const noexcept
+        {
+            std::size_t n = 2;
+            while (n < ring_capacity) n <<= 1;
+            return capacity.load(std::memory_order_relaxed) == n && deferred() == defer;
+        }
+
+        void start(std::size_t ring_capacity, bool defer)
+        {
+            stop();
+
+            // Round up to a power of two so that ring indexes can be masked.
+            std::size_t n = 2;
+            while (n < ring_capacity) n <<= 1;
+            capacity.store(n, std::memory_order_relaxed);
+
+            core = boost::log::core::get();
+            stopping.store(false, std::memory_order_relaxed);
+            generation.fetch_add(1, std::memory_order_release);
+            backend = std::thread(&dispatcher::run, this);
+            backend_id = backend.get_id();
+            deferring.store(defer, std::memory_order_relaxed);
+            running.store(true, std::memory_order_release);
+        }
+
+        void stop()
+        {
+            if (!running.exchange(false, std::memory_order_seq_cst)) return;
+            deferring.store(false, std::memory_order_relaxed);
+
+            // Producers that saw the dispatcher running complete their push while the backend still drains.
+            while (pushing.load(std::memory_order_seq_cst))
+            {
+                wake();
+                std::this_thread::yield();
+            }
+
+            {
+                std::lock_guard _(mutex);
+                stopping.store(true, std::memory_order_release);
+                wakeup.notify_one();
+            }
+            backend.join();
+            backend_id = {};
+
+            {
+                std::lock_guard _(mutex);
+                flushed.notify_all();
+            }
+
+            // Records racing with the stop request are delivered synchronously.
+            std::vector<std::shared_ptr<ring>> snapshot;
+            std::size_t version = static_cast<std::size_t>(-1);
+            drain(snapshot, version);
+            core->flush();
+        }
+
+        /**
+         * @brief Queue the record for the backend thread, or return false to have it pushed synchronously if the
+         * dispatcher is stopped or the caller is the backend thread, whose ring nobody else would drain.
+         */
+        bool push(boost::log::record& rec)
+        {
+            if (std::this_thread::get_id() == backend_id) return false;
+            pushing.fetch_add(1, std::memory_order_seq_cst);
+            if (!running.load(std::memory_order_seq_cst))
+            {
+                pushing.fetch_sub(1, std::memory_order_release);
+                return false;
+            }
+
+            auto& r = local_ring();
+            while (!r.push(rec))
+            {
+                wake();
+                std::this_thread::yield();
+            }
+            pushing.fetch_sub(1, std::memory_order_release);
+            wake();
+            return true;
+        }
+
+        void flush()
+        {
+            if (!enabled() || std::this_thread::get_id() == backend_id)
+            {
+                core->flush();
+                return;
+            }
+
+            std::unique_lock lock(mutex);
+            auto ticket = flush_requested.fetch_add(1, std::memory_order_acq_rel) + 1;
+            wakeup.notify_one();
+            flushed.wait(lock, [&] {
+                return flush_completed.load(std::memory_order_acquire) >= ticket ||
+                       !running.load(std::memory_order_acquire);
+            });
+        }
+    };
+
+    dispatcher global;
+}
+
+namespace ing::logging
+{
+    /**
+     * @brief Set while a BinaryFile sink is configured, which stores the arguments of deferred messages.
+     */
+    std::atomic<bool> storing_arguments{false};
+
+    bool deferred_formatting() noexcept
+    {
+        return async::global.deferred() || storing_arguments.load(std::memory_order_relaxed);
+    }
+
+    std::mutex& reload_guard()
+    {
+        static std::mutex& guard = *new std::mutex;
+        return guard;
+    }
+
+    std::condition_variable& reload_done()
+    {
+        static std::condition_variable& done = *new std::condition_variable;
+        return done;
+    }
+
+    void wait_reloaded() noexcept
+    {
+        std::unique_lock lock(reload_guard());
+        reload_done().wait(lock, [] { return (reload_generation.load(std::memory_order_acquire) & 1) == 0; });
+    }
+
+    void dump_flight_recorder(const boost::log::record& rec);
+
+    bool enqueue_record(boost::log::record& rec)
+    {
+        dump_flight_recorder(rec);
+        if (!async::global.enabled()) return false;
+
+        // Thread-specific values must be detached on the producer thread before crossing over.
+        // It is what boost::log::record::lock() does for cross-thread sinks.
+        auto& values = rec.attribute_values();
+        for (const auto& value : values)
+            const_cast<boost::log::attribute_value&>(value.second).detach_from_thread();
+
+        auto level = values[expressions::severity];
+        bool fatal = level && *level >= severity_level::fatal;
+        if (!async::global.push(rec)) return false;
+        if (fatal) async::global.flush();
+        return true;
+    }
+}
+
+namespace ing::logging
+{
+    /**
+     * @brief Ring of flight slots owned by one thread at a time. Rings are never freed, a ring left by an exited
+     * thread keeps its records until another thread takes it over, so that a crash dump can still read them.
+     */
+    struct flight_ring
+    {
+        const std::size_t capacity;
+        const std::unique_ptr<flight_slot[]> slots;
+        std::atomic<std::uint64_t> next{0};  // written by the owner only
+        std::atomic<bool> owned{true};
+        flight_ring* link = nullptr;
+        boost::log::aux::thread::id thread_id;
+        ing::string thread_name;
+        std::uint64_t cursor = 0, end = 0;   // sequences left to dump, guarded by the dumping flag
+
+        explicit flight_ring(std::size_t capacity)
+            : capacity(capacity), slots(new flight_slot[capacity]()) {}
+
+        void adopt()
+        {
+            for (std::size_t i = 0; i < capacity; ++i)
+                slots[i].sequence.store(0, std::memory_order_relaxed);
+            thread_id = boost::log::aux::this_thread::get_id();
+            thread_name = ing::get_thread_name();
+        }
+    };
+
+    struct flight_owner
+    {
+        flight_ring* ring = nullptr;
+        ~flight_owner() { if (ring) ring->owned.store(false, std::memory_order_release); }
+    };
+
+    /**
+     * @brief Copy of a flight slot, taken while the owner of the ring may be rewriting it.
+     */
+    struct flight_entry
+    {
+        flight_ring* ring;
+        flight_slot* slot;
+        std::uint64_t sequence;
+        std::int64_t time;
+        const interned_channel* channel;
+        callsite_id callsite;
+        severity_level severity;
+        std::uint16_t size;
+        bool truncated;
+        unsigned char payload[sizeof(flight_slot::payload)];
+
+        /**
+         * @brief Copies the slot if it holds the record of the sequence. Like a seqlock, the sequence is read
+         * again after the copy, which is discarded if the slot was reused meanwhile.
+         */
+        bool take(flight_ring* r, flight_slot* s, std::uint64_t seq) noexcept
+        {
+            if (s->sequence.load(std::memory_order_acquire) != seq) return false;
+            ring = r;
+            slot = s;
+            sequence = seq;
+            time = s->time;
+            channel = s->channel;
+            callsite = s->callsite;
+            severity = s->severity;
+            size = std::min<std::uint16_t>(s->size, sizeof(payload));
+            truncated = s->truncated;
+            std::memcpy(payload, s->payload, sizeof(payload));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return s->sequence.load(std::memory_order_relaxed) == seq;
+        }
+    };
+
+    /**
+     * @brief Line of the crash dump, filled in place since the signal handler must not allocate.
+     */
+    struct flight_line
+    {
+        char data[512];
+        std::size_t size = 0;
+
+        void append(const char* s, std::size_t n) noexcept
+        {
+            n = std::min(n, sizeof(data) - 1 - size);  // the newline always fits
+            std::memcpy(data + size, s, n);
+            size += n;
+        }
+
+        void append(std::string_view s) noexcept { append(s.data(), s.size()); }
+        void push_back(char c) noexcept { append(&c, 1); }
+    };
+
+    class flight_recorder
+    {
+        std::atomic<std::size_t> capacity{0};
+        std::atomic<flight_ring*> rings{nullptr};
+        std::atomic<bool> dumping{false};
+        std::atomic<int> output{2};  // descriptor the signal handler writes to, stderr by default
+
+        static inline thread_local flight_owner local;
+        static constexpr int signals[] = { SIGSEGV, SIGABRT };
+#ifdef _WIN32
+        static inline void (*previous[2])(int) = { SIG_DFL, SIG_DFL };
+#else
+        static inline struct sigaction previous[2];
+#endif
+
+        flight_ring* acquire(std::size_t n)
+        {
+            if (local.ring) local.ring->owned.store(false, std::memory_order_release);
+            local.ring = nullptr;
+
+            for (auto* r = rings.load(std::memory_order_acquire); r; r = r->link)
+            {
+                bool owned = false;
+                if (r->capacity == n && r->owned.compare_exchange_strong(owned, true, std::memory_order_acquire))
+                {
+                    r->adopt();
+                    return local.ring = r;
+                }
+            }
+
+            auto* r = new flight_ring(n);
+            r->adopt();
+            r->link = rings.load(std::memory_order_relaxed);
+            while (!rings.compare_exchange_weak(r->link, r, std::memory_order_release, std::memory_order_relaxed));
+            return local.ring = r;
+        }
+
+        /**
+         * @brief Calls f with the records of all threads oldest first, by merging the rings, each of which is in
+         * order already. Neither allocates nor locks, so that the signal handler can use it. Records are dumped
+         * once, unless the slot was reused meanwhile.
+         */
+        template<typename F>
+        void drain(F&& f)
+        {
+            auto* first = rings.load(std::memory_order_acquire);
+            for (auto* r = first; r; r = r->link)
+            {
+                r->end = r->next.load(std::memory_order_relaxed);
+                r->cursor = r->end > r->capacity ? r->end - r->capacity + 1 : 1;
+            }
+
+            flight_entry head, oldest;
+            for (;;)
+            {
+                bool found = false;
+                for (auto* r = first; r; r = r->link)
+                {
+                    for (; r->cursor <= r->end; ++r->cursor)
+                        if (head.take(r, &r->slots[r->cursor & (r->capacity - 1)], r->cursor)) break;
+                    if (r->cursor <= r->end && (!found || head.time < oldest.time))
+                    {
+                        oldest = head;
+                        found = true;
+                    }
+                }
+                if (!found) return;
+
+                ++oldest.ring->cursor;
+                f(static_cast<const flight_entry&>(oldest));
+                auto seq = oldest.sequence;
+                oldest.slot->sequence.compare_exchange_strong(seq, 0, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * @brief Writes the records with write(2) only, as the crash may have left the heap or a sink lock
+         * in any state.
+         */
+        static void on_signal(int sig)
+        {
+            auto& recorder = get();
+            if (!recorder.dumping.exchange(true, std::memory_order_acquire))
+            {
+                int fd = recorder.output.load(std::memory_order_relaxed);
+                recorder.drain([fd](const flight_entry& e) {
+                    flight_line line;
+                    format(e, line);
+                    line.data[line.size++] = '\n';
+                    for (const char* p = line.data; line.size > 0;)
+                    {
+#ifdef _WIN32
+                        int w = ::_write(fd, p, static_cast<unsigned>(line.size));
+#else
+                        auto w = ::write(fd, p, line.size);
+#endif
+                        if (w < 0 && errno == EINTR) continue;
+                        if (w <= 0) break;
+                        p += w;
+                        line.size -= static_cast<std::size_t>(w);
+                    }
+                });
+            }
+
+            // Chain to the handler replaced, or the default action, by raising the signal again.
+            std::size_t i = sig == SIGSEGV ? 0 : 1;
+#ifdef _WIN32
+            std::signal(sig, previous[i]);
+#else
+            sigaction(sig, &previous[i], nullptr);
+#endif
+            std::raise(sig);
+        }
+
+        static void install()
+        {
+            for (std::size_t i = 0; i < std::size(signals); ++i)
+            {
+#ifdef _WIN32
+                auto p = std::signal(signals[i], &flight_recorder::on_signal);
+                if (p != &flight_recorder::on_signal) previous[i] = p == SIG_ERR ? SIG_DFL : p;
+#else
+                struct sigaction current;
+                if (sigaction(signals[i], nullptr, &current) == 0 &&
+                    !(current.sa_flags & SA_SIGINFO) && current.sa_handler == &flight_recorder::on_signal)
+                    continue;
+
+                struct sigaction action = {};
+                action.sa_handler = &flight_recorder::on_signal;
+                action.sa_flags = SA_ONSTACK;
+                sigemptyset(&action.sa_mask);
+                sigaction(signals[i], &action, &previous[i]);
+#endif
+            }
+        }
+
+    public:
+        static flight_recorder& get()
+        {
+            static flight_recorder& recorder = *new flight_recorder;
+            return recorder;
+        }
+
+        bool enabled() const noexcept
+        {
+            return capacity.load(std::memory_order_relaxed) != 0;
+        }
+
+        void configure(std::size_t records, const std::string& file)
+        {
+            std::size_t n = 0;
+            if (records > 0)
+            {
+                n = 2;
+                while (n < records) n <<= 1;
+            }
+
+            int fd = 2;
+            if (n > 0 && !file.empty())
+            {
+#ifdef _WIN32
+                fd = ::_open(file.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, 0644);
+#else
+                fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+                if (fd < 0) throw std::system_error(errno, std::generic_category(), file);
+            }
+            // The descriptor replaced is left open, the signal handler may be writing to it.
+            output.store(fd, std::memory_order_relaxed);
+
+            capacity.store(n, std::memory_order_relaxed);
+            flight_recording.store(n > 0, std::memory_order_relaxed);
+            if (n > 0) install();
+        }
+
+        flight_slot* begin(severity_level level, const interned_channel* channel,
+                           callsite_id id, std::uint64_t& sequence) noexcept
+        {
+            auto n = capacity.load(std::memory_order_relaxed);
+            auto* r = local.ring;
+            if (!r || r->capacity != n)
+            {
+                if (n == 0) return nullptr;
+                try { r = acquire(n); } catch (...) { return nullptr; }
+            }
+
+            sequence = r->next.load(std::memory_order_relaxed) + 1;
+            r->next.store(sequence, std::memory_order_relaxed);
+            auto& slot = r->slots[sequence & (r->capacity - 1)];
+            // The writer side of the seqlock read by flight_entry::take.
+            slot.sequence.store(0, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+#ifdef CLOCK_REALTIME_COARSE
+            // A few milliseconds of resolution for a fraction of the cost, records of a thread are ordered anyway.
+            timespec ts;
+            clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+            slot.time = static_cast<std::int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+#else
+            slot.time = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+#endif
+            slot.channel = channel;
+            slot.callsite = id;
+            slot.severity = level;
+            slot.size = 0;
+            slot.truncated = false;
+            return &slot;
+        }
+
+        /**
+         * @brief Pushes the records into the sinks, used on fatal records. Crashes go through on_signal instead.
+         */
+        void dump()
+        {
+            if (dumping.exchange(true, std::memory_order_acquire)) return;
+
+            auto core = boost::log::core::get();
+            drain([&core](const flight_entry& e) {
+                boost::log::attribute_set attrs;
+                attrs.insert(expressions::severity_type::get_name(),
+                             boost::log::attributes::constant<severity_level>(e.severity));
+                attrs.insert(expressions::channel_type::get_name(),
+                             boost::log::attributes::constant<channel_name>(
+                                     e.channel ? channel_name(e.channel) : channel_name()));
+                attrs.insert(expressions::location_type::get_name(),
+                             boost::log::attributes::constant<callsite_id>(e.callsite));
+                attrs.insert(expressions::timestamp_type::get_name(),
+                             boost::log::attributes::constant<expressions::timestamp_type::value_type>(
+                                     local_time(e.time)));
+                attrs.insert(expressions::thread_id_type::get_name(),
+                             boost::log::attributes::constant<expressions::thread_id_type::value_type>(e.ring->thread_id));
+                attrs.insert(expressions::thread_name_type::get_name(),
+                             boost::log::attributes::constant<ing::string>(e.ring->thread_name));
+
+                if (auto rec = core->open_record(attrs))
+                {
+                    std::string text;
+                    render(e, text);
+                    rec.attribute_values().insert(expressions::names::message(),
+                            boost::log::attributes::make_attribute_value(std::move(text)));
+                    core->push_record(std::move(rec));
+                }
+            });
+
+            dumping.store(false, std::memory_order_release);
+        }
+
+        static expressions::timestamp_type::value_type local_time(std::int64_t us)
+        {
+            using namespace boost::posix_time;
+            auto second = static_cast<std::time_t>(us / 1000000);
+            std::tm tm;
+#ifdef _WIN32
+            localtime_s(&tm, &second);
+#else
+            localtime_r(&second, &tm);
+#endif
+            return ptime(boost::gregorian::date_from_tm(tm), time_duration(tm.tm_hour, tm.tm_min, tm.tm_sec)) +
+                   microseconds(us % 1000000);
+        }
+
+        template<typename Text>
+        static void append_number(Text& text, std::uint64_t v, int width = 0)
+        {
+            char buf[24];
+            auto end = std::to_chars(buf, buf + sizeof(buf), v).ptr;
+            for (auto n = end - buf; n < width; ++n) text.push_back('0');
+            text.append(buf, static_cast<std::size_t>(end - buf));
+        }
+
+        /**
+         * @brief Formats the message kept in the slot, without allocating when Text does not.
+         */
+        template<typename Text>
+        static void render(const flight_entry& e, Text& text)
+        {
+            text.append("[flight] ");
+            char buf[64];
+            const unsigned char* p = e.payload;
+            const unsigned char* end = p + e.size;
+            while (p < end)
+            {
+                auto tag = static_cast<argument_tag>(*p++);
+                switch (tag)
+                {
+                case signed_tag:
+                case unsigned_tag:
+                case floating_tag:
+                {
+                    if (end - p < 8) return;
+                    std::uint64_t bits;
+                    std::memcpy(&bits, p, sizeof(bits));
+                    p += sizeof(bits);
+                    char* last;
+                    if (tag == signed_tag)
+                        last = std::to_chars(buf, buf + sizeof(buf), static_cast<std::int64_t>(bits)).ptr;
+                    else if (tag == unsigned_tag)
+                        last = std::to_chars(buf, buf + sizeof(buf), bits).ptr;
+                    else
+                    {
+                        double v;
+                        std::memcpy(&v, &bits, sizeof(v));
+#if __cpp_lib_to_chars >= 201611L
+                        last = std::to_chars(buf, buf + sizeof(buf), v, std::chars_format::general, 6).ptr;
+#else
+                        last = buf + std::snprintf(buf, sizeof(buf), "%g", v);
+#endif
+                    }
+                    text.append(buf, static_cast<std::size_t>(last - buf));
+                    break;
+                }
+                case char_tag:
+                    if (p < end) text.push_back(static_cast<char>(*p++));
+                    break;
+                case bool_tag:
+                    if (p < end) text.push_back(*p++ ? '1' : '0');
+                    break;
+                case string_tag:
+                {
+                    std::size_t n = p < end ? *p++ : 0;
+                    n = std::min<std::size_t>(n, static_cast<std::size_t>(end - p));
+                    text.append(reinterpret_cast<const char*>(p), n);
+                    p += n;
+                    break;
+                }
+                default:
+                    text.append("{?}");
+                    break;
+                }
+            }
+            if (e.truncated) text.append("...");
+        }
+
+        /**
+         * @brief Formats a line of the crash dump, e.g. 2024-01-31 12:00:00.000000Z DEBUG <db> [worker]
+         * query.cpp:42 [flight] message. The time is in UTC, as localtime_r is not async-signal-safe.
+         */
+        static void format(const flight_entry& e, flight_line& line) noexcept
+        {
+            // Civil date from the days since the epoch, see http://howardhinnant.github.io/date_algorithms.html
+            auto seconds = e.time / 1000000;
+            auto us = static_cast<std::uint64_t>(e.time % 1000000);
+            auto days = seconds / 86400 + 719468;
+            auto second_of_day = static_cast<std::uint64_t>(seconds % 86400);
+            auto era = days / 146097;
+            auto doe = static_cast<std::uint64_t>(days - era * 146097);
+            auto yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+            auto doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+            auto mp = (5 * doy + 2) / 153;
+            auto day = doy - (153 * mp + 2) / 5 + 1;
+            auto month = mp < 10 ? mp + 3 : mp - 9;
+            auto year = static_cast<std::uint64_t>(era * 400) + yoe + (month <= 2);
+
+            append_number(line, year, 4);
+            line.push_back('-');
+            append_number(line, month, 2);
+            line.push_back('-');
+            append_number(line, day, 2);
+            line.push_back(' ');
+            append_number(line, second_of_day / 3600, 2);
+            line.push_back(':');
+            append_number(line, second_of_day / 60 % 60, 2);
+            line.push_back(':');
+            append_number(line, second_of_day % 60, 2);
+            line.push_back('.');
+            append_number(line, us, 6);
+            line.append("Z ");
+
+            auto* level = to_string(e.severity);
+            line.append(level ? level : "?");
+            line.append(" <");
+            if (e.channel) line.append(e.channel->name);
+            line.append("> ");
+            if (!e.ring->thread_name.empty())
+            {
+                line.push_back('[');
+                line.append(e.ring->thread_name.view());
+                line.append("] ");
+            }
+
+            const auto& loc = callsite_location(e.callsite);
+            if (const char* file = loc.file_name())
+            {
+                std::string_view path(file);
+                line.append(path.substr(path.find_last_of("/\\") + 1));
+                line.push_back(':');
+                append_number(line, loc.line());
+                line.push_back(' ');
+            }
+            render(e, line);
+        }
+    };
+
+    flight_slot* flight_begin(severity_level level, const interned_channel* channel,
+                              callsite_id id, std::uint64_t& sequence) noexcept
+    {
+        return flight_recorder::get().begin(level, channel, id, sequence);
+    }
+
+    flight_slot* flight_begin(severity_level level, const interned_channel* channel,
+                              const source_location& loc, std::uint64_t& sequence) noexcept
+    {
+        auto& recorder = flight_recorder::get();
+        if (!recorder.enabled()) return nullptr;
+        try { return recorder.begin(level, channel, register_callsite(loc), sequence); } catch (...) { return nullptr; }
+    }
+
+    void dump_flight_recorder()
+    {
+        flight_recorder::get().dump();
+    }
+
+    /**
+     * @brief The context kept by the flight recorder precedes a fatal record.
+     */
+    void dump_flight_recorder(const boost::log::record& rec)
+    {
+        auto& recorder = flight_recorder::get();
+        if (!recorder.enabled()) return;
+        auto level = rec.attribute_values()[expressions::severity];
+        if (!level || *level < severity_level::fatal) return;
+        if (async::global.enabled()) async::global.flush();
+        recorder.dump();
+    }
+}
+
+namespace ing::logging::metrics
+{
+    constexpr std::size_t severities = 6;
+    constexpr std::size_t latency_buckets = 40;  // bucket b counts latencies below 2^b ns
+
+    struct channel_counters
+    {
+        std::atomic<std::uint64_t> emitted[severities];
+        std::atomic<std::uint64_t> filtered[severities];
+        std::atomic<std::uint64_t> bytes[severities];
+    };
+
+    struct latency_histogram
+    {
+        std::atomic<std::uint64_t> buckets[latency_buckets];
+        std::atomic<std::uint64_t> sum;  // ns
+    };
+
+    // Counters of a shard are written by the thread owning it only, so no read-modify-write is needed.
+    inline void bump(std::atomic<std::uint64_t>& counter, std::uint64_t n) noexcept
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Table of counters indexed by id, allocated by chunks once written. Ids beyond the table are not counted.
+     */
+    template<typename T, std::size_t Chunk, std::size_t Chunks>
+    class sparse_table
+    {
+        std::atomic<T*> chunks[Chunks] = {};
+
+    public:
+        static constexpr std::size_t size = Chunk * Chunks;
+
+        T* get(std::size_t id)
+        {
+            if (id >= size) return nullptr;
+            auto& chunk = chunks[id / Chunk];
+            auto* p = chunk.load(std::memory_order_relaxed);
+            if (!p)
+            {
+                p = new T[Chunk]();
+                chunk.store(p, std::memory_order_release);
+            }
+            return p + id % Chunk;
+        }
+
+        const T* find(std::size_t id) const noexcept
+        {
+            if (id >= size) return nullptr;
+            auto* p = chunks[id / Chunk].load(std::memory_order_acquire);
+            return p ? p + id % Chunk : nullptr;
+        }
+    };
+
+    /**
+     * @brief Counters of a thread. Shards are never freed, the shard of an exited thread is adopted by the
+     * next thread needing one, so that its counts keep adding up.
+     */
+    struct shard
+    {
+        sparse_table<channel_counters, 64, 1024> channels;
+        sparse_table<latency_histogram, 16, 64> sinks;
+        std::atomic<bool> owned{true};
+        shard* link = nullptr;
+    };
+
+    struct shard_owner
+    {
+        shard* s = nullptr;
+        ~shard_owner() { if (s) s->owned.store(false, std::memory_order_release); }
+    };
+
+    class shards
+    {
+        std::atomic<shard*> head{nullptr};
+        static inline thread_local shard_owner local;
+
+    public:
+        static shards& get()
+        {
+            static shards& all = *new shards;
+            return all;
+        }
+
+        shard& acquire()
+        {
+            if (local.s) return *local.s;
+            for (auto* s = head.load(std::memory_order_acquire); s; s = s->link)
+            {
+                bool owned = false;
+                if (s->owned.compare_exchange_strong(owned, true, std::memory_order_acquire))
+                    return *(local.s = s);
+            }
+
+            auto* s = new shard;
+            s->link = head.load(std::memory_order_relaxed);
+            while (!head.compare_exchange_weak(s->link, s, std::memory_order_release, std::memory_order_relaxed));
+            return *(local.s = s);
+        }
+
+        template<typename F>
+        void each(F f) const
+        {
+            for (auto* s = head.load(std::memory_order_acquire); s; s = s->link)
+                f(*s);
+        }
+    };
+
+    void count_filtered(const interned_channel* channel, severity_level level) noexcept
+    {
+        if (auto* c = shards::get().acquire().channels.get(channel->id))
+            bump(c->filtered[static_cast<std::size_t>(level)], 1);
+    }
+
+    void count_emitted(const interned_channel* channel, severity_level level, std::size_t bytes) noexcept
+    {
+        if (auto* c = shards::get().acquire().channels.get(channel->id))
+        {
+            bump(c->emitted[static_cast<std::size_t>(level)], 1);
+            bump(c->bytes[static_cast<std::size_t>(level)], bytes);
+        }
+    }
+
+    /**
+     * @brief Metrics of a sink configured by init_logging. Sinks configured under the same name share their
+     * latency histograms across reloads, the queue depth is of the sink itself.
+     */
+    struct sink_meter
+    {
+        const std::uint32_t id;
+        std::atomic<std::size_t> depth{0};
+
+        explicit sink_meter(std::uint32_t id) noexcept : id(id) {}
+
+        void record(std::chrono::steady_clock::duration latency) noexcept
+        {
+            auto ns = static_cast<std::uint64_t>(std::max<std::chrono::nanoseconds::rep>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count(), 0));
+            std::size_t bucket = 0;
+            while (bucket + 1 < latency_buckets && (ns >> bucket) != 0) ++bucket;
+            if (auto* h = shards::get().acquire().sinks.get(id))
+            {
+                bump(h->buckets[bucket], 1);
+                bump(h->sum, ns);
+            }
+        }
+    };
+
+    /**
+     * @brief Names of the sinks metered so far, and the meters alive for their queue depth.
+     */
+    class sink_registry
+    {
+        std::mutex guard;
+        std::vector<std::string> names;
+        std::vector<std::weak_ptr<sink_meter>> meters;
+
+    public:
+        static sink_registry& get()
+        {
+            static sink_registry& registry = *new sink_registry;
+            return registry;
+        }
+
+        std::shared_ptr<sink_meter> meter(const std::string& name)
+        {
+            std::lock_guard _(guard);
+            auto iter = std::find(names.begin(), names.end(), name);
+            auto id = static_cast<std::uint32_t>(iter - names.begin());
+            if (iter == names.end()) names.push_back(name);
+            auto m = std::make_shared<sink_meter>(id);
+            meters.erase(std::remove_if(meters.begin(), meters.end(), [](const auto& w) { return w.expired(); }),
+                         meters.end());
+            meters.push_back(m);
+            return m;
+        }
+
+        std::vector<std::string> snapshot(std::vector<std::size_t>& depths)
+        {
+            std::lock_guard _(guard);
+            depths.assign(names.size(), 0);
+            for (const auto& w : meters)
+                if (auto m = w.lock()) depths[m->id] += m->depth.load(std::memory_order_relaxed);
+            return names;
+        }
+    };
+
+    void report(std::ostream& os)
+    {
+        boost::io::ios_flags_saver ifs(os);
+        boost::io::ios_precision_saver ips(os);
+        os.setf(std::ios_base::fixed, std::ios_base::floatfield);
+        os.precision(3);
+
+        os << "channel" << '\t' << "severity" << '\t' << "emitted" << '\t' << "filtered" << '\t' << "bytes" << '\n';
+        for (auto* channel : channel_table::get().channels())
+        {
+            std::uint64_t emitted[severities] = {}, filtered[severities] = {}, bytes[severities] = {};
+            shards::get().each([&](const shard& s)
+            {
+                if (auto* c = s.channels.find(channel->id))
+                {
+                    for (std::size_t i = 0; i < severities; ++i)
+                    {
+                        emitted[i] += c->emitted[i].load(std::memory_order_relaxed);
+                        filtered[i] += c->filtered[i].load(std::memory_order_relaxed);
+                        bytes[i] += c->bytes[i].load(std::memory_order_relaxed);
+                    }
+                }
+            });
+            for (std::size_t i = 0; i < severities; ++i)
+            {
+                if (emitted[i] == 0 && filtered[i] == 0) continue;
+                os << channel->name << '\t' << to_string(static_cast<severity_level>(i)) << '\t'
+                   << emitted[i] << '\t' << filtered[i] << '\t' << bytes[i] << '\n';
+            }
+        }
+
+        std::vector<std::size_t> depths;
+        auto names = sink_registry::get().snapshot(depths);
+        os << "sink" << '\t' << "records" << '\t' << "mean" << '\t' << "p50" << '\t' << "p90" << '\t'
+           << "p99" << '\t' << "max" << '\t' << "queued" << '\n';
+        for (std::size_t id = 0; id < names.size(); ++id)
+        {
+            std::uint64_t buckets[latency_buckets] = {}, sum = 0, count = 0;
+            shards::get().each([&](const shard& s)
+            {
+                if (auto* h = s.sinks.find(id))
+                {
+                    for (std::size_t i = 0; i < latency_buckets; ++i)
+                        buckets[i] += h->buckets[i].load(std::memory_order_relaxed);
+                    sum += h->sum.load(std::memory_order_relaxed);
+                }
+            });
+            for (auto n : buckets) count += n;
+
+            // Percentiles are the upper bounds of their buckets.
+            auto bound = [](std::size_t bucket) { return static_cast<double>(std::uint64_t(1) << bucket) / 1e3; };
+            auto percentile = [&](double q)
+            {
+                std::uint64_t seen = 0;
+                for (std::size_t i = 0; i < latency_buckets; ++i)
+                    if ((seen += buckets[i]) > 0 && static_cast<double>(seen) >= q * static_cast<double>(count))
+                        return bound(i);
+                return 0.0;
+            };
+            os << names[id] << '\t' << count << '\t'
+               << (count ? static_cast<double>(sum) / static_cast<double>(count) / 1e3 : 0.0) << '\t'
+               << percentile(0.5) << '\t' << percentile(0.9) << '\t' << percentile(0.99) << '\t'
+               << percentile(1.0) << '\t' << depths[id] << '\n';
+        }
+    }
+}
+
+namespace ing::logging::sinks
+{
+    static std::int64_t local_microseconds(const boost::posix_time::ptime& time)
+    {
+        return (time - boost::posix_time::ptime(boost::gregorian::date(1970, 1, 1))).total_microseconds();
+    }
+
+    // Layout of the sidecar index FILE.idx of a BatchedFile sink, in the byte order of the writer. An entry
+    // describes a block of consecutive records and is written once the block is in the file.
+    struct index_file_header
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t order;
+        char reserved[48];
+    };
+
+    struct index_entry
+    {
+        std::uint64_t offset;
+        std::uint64_t size;
+        std::int64_t first;  // time stamp range, first > last if no record has one
+        std::int64_t last;
+        std::uint32_t records;
+        std::uint8_t severities;  // bit per severity level, records without severity set all
+        std::uint8_t reserved[3];
+        std::uint64_t channels[4];  // bloom filter of the channel names
+
+        void add(std::string_view channel) noexcept
+        {
+            // FNV-1a, stable across processes.
+            std::uint64_t h = 0xcbf29ce484222325;
+            for (unsigned char c : channel)
+                h = (h ^ c) * 0x100000001b3;
+            for (int i = 0; i < 3; ++i, h >>= 8)
+                channels[(h >> 6) & 3] |= std::uint64_t(1) << (h & 63);
+        }
+
+        bool may_contain(std::string_view channel) const noexcept
+        {
+            index_entry probe{};
+            probe.add(channel);
+            for (int i = 0; i < 4; ++i)
+                if ((channels[i] & probe.channels[i]) != probe.channels[i]) return false;
+            return true;
+        }
+    };
+
+    static constexpr char index_magic[8] = { 'i', 'n', 'g', 'i', 'n', 'd', 'e', 'x' };
+    static constexpr std::uint32_t index_version = 1;
+    static constexpr std::uint32_t index_order = 0x01020304;
+
+    static_assert(sizeof(index_file_header) == 64);
+    static_assert(sizeof(index_entry) == 72);
+
+    /**
+     * @brief File sink backend writing records in batches, one writev per batch. A batch is committed once
+     * it holds enough bytes or records, once its oldest record is pending for too long, or as soon as a
+     * record at or above the flush severity is consumed.
+     */
+    class batched_file_backend : public boost::log::sinks::basic_formatted_sink_backend<char,
+            boost::log::sinks::combine_requirements<boost::log::sinks::synchronized_feeding,
+                                                    boost::log::sinks::flushing>::type>
+    {
+    public:
+        struct policy
+        {
+            std::size_t bytes = 64 * 1024;
+            std::size_t records = 1024;
+            std::chrono::milliseconds latency{100};
+            severity_level severity = severity_level::error;
+            std::size_t index_records = 0;  // records per index entry, 0 for no limit
+            std::size_t index_bytes = 0;    // bytes per index entry, 0 for no limit
+        };
+
+    private:
+        static constexpr std::size_t block_size = 64 * 1024;
+
+        const std::string file;
+        const policy limits;
+        int fd = -1;
+
+        // Sidecar index, entries are written once the records they describe are committed.
+        int index_fd = -1;
+        std::uint64_t index_size = 0;  // index file size up to the last complete entry
+        std::uint64_t offset = 0;  // file offset past the records consumed
+        index_entry block{};
+        std::vector<index_entry> indexed;
+
+        // Records are copied into fixed blocks so that a growing batch never moves, each block is one iovec.
+        std::vector<std::string> blocks;
+        std::size_t used = 0;  // blocks holding pending records
+        std::size_t pending_bytes = 0;
+        std::size_t pending_records = 0;
+        std::chrono::steady_clock::time_point oldest;
+
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        std::thread timer;
+        bool stopping = false;
+
+        std::atomic<std::uint64_t> records{0};
+        std::atomic<std::uint64_t> bytes{0};
+        std::atomic<std::uint64_t> syscalls{0};
+        std::atomic<std::uint64_t> failed_batches{0};
+        std::atomic<std::uint64_t> lost_records{0};
+
+        char* reserve(std::size_t n)
+        {
+            if (used == 0 || blocks[used - 1].capacity() - blocks[used - 1].size() < n)
+            {
+                if (used == blocks.size()) blocks.emplace_back();
+                auto& block = blocks[used++];
+                block.reserve(std::max(n, block_size));
+            }
+            auto& block = blocks[used - 1];
+            auto size = block.size();
+            block.resize(size + n);
+            return block.data() + size;
+        }
+
+        void commit()
+        {
+            if (pending_records == 0) return;
+
+            std::size_t calls = 0;
+            std::size_t unwritten = 0;
+#ifdef _WIN32
+            for (std::size_t i = 0; i < used; ++i)
+            {
+                const char* p = blocks[i].data();
+                std::size_t n = blocks[i].size();
+                while (n > 0)
+                {
+                    int w = ::_write(fd, p, static_cast<unsigned>(std::min<std::size_t>(n, INT_MAX)));
+                    ++calls;
+                    if (w < 0) break;
+                    p += w;
+                    n -= static_cast<std::size_t>(w);
+                }
+                unwritten += n;
+                if (n > 0)
+                {
+                    for (std::size_t j = i + 1; j < used; ++j) unwritten += blocks[j].size();
+                    break;
+                }
+            }
+#else
+            std::vector<iovec> iov(used);
+            for (std::size_t i = 0; i < used; ++i)
+                iov[i] = { blocks[i].data(), blocks[i].size() };
+
+            iovec* first = iov.data();
+            iovec* last = first + used;
+            while (first != last)
+            {
+                auto n = ::writev(fd, first, static_cast<int>(std::min<std::ptrdiff_t>(last - first, IOV_MAX)));
+                ++calls;
+                if (n < 0)
+                {
+                    if (errno == EINTR) continue;
+                    for (; first != last; ++first) unwritten += first->iov_len;
+                    break;
+                }
+                // Skip what was written, a short write resumes in the middle of a block.
+                auto written = static_cast<std::size_t>(n);
+                while (first != last && written >= first->iov_len)
+                    written -= (first++)->iov_len;
+                if (first != last)
+                {
+                    first->iov_base = static_cast<char*>(first->iov_base) + written;
+                    first->iov_len -= written;
+                }
+            }
+#endif
+
+            // A failed write, e.g. ENOSPC or EIO, loses the rest of the batch. Index entries of the batch are
+            // dropped, the records they describe then read as not indexed.
+            if (unwritten == 0)
+            {
+                records.fetch_add(pending_records, std::memory_order_relaxed);
+            }
+            else
+            {
+                failed_batches.fetch_add(1, std::memory_order_relaxed);
+                lost_records.fetch_add(pending_records, std::memory_order_relaxed);
+                offset -= unwritten;
+                indexed.clear();
+                block = {};
+            }
+            bytes.fetch_add(pending_bytes - unwritten, std::memory_order_relaxed);
+            syscalls.fetch_add(calls, std::memory_order_relaxed);
+
+            for (std::size_t i = 0; i < used; ++i)
+                blocks[i].clear();
+            used = 0;
+            pending_bytes = 0;
+            pending_records = 0;
+
+            write_index();
+        }
+
+        void index(const boost::log::record_view& rec, std::size_t n)
+        {
+            if (block.records++ == 0)
+            {
+                block.offset = offset;
+                block.first = INT64_MAX;
+                block.last = INT64_MIN;
+            }
+            block.size += n;
+
+            if (auto time = rec[expressions::timestamp]; time && !time->is_special())
+            {
+                auto us = local_microseconds(*time);
+                block.first = std::min(block.first, us);
+                block.last = std::max(block.last, us);
+            }
+            auto level = rec[expressions::severity];
+            block.severities |= level ? static_cast<std::uint8_t>(1u << static_cast<unsigned>(*level)) : 0xff;
+            if (auto channel = rec[expressions::channel])
+                block.add(channel->view());
+
+            if ((limits.index_records && block.records >= limits.index_records) ||
+                (limits.index_bytes && block.size >= limits.index_bytes))
+                seal();
+        }
+
+        void seal()
+        {
+            if (block.records == 0) return;
+            indexed.push_back(block);
+            block = {};
+        }
+
+        /**
+         * @brief Cut the index back to its last complete entry, or stop indexing if it cannot be.
+         */
+        void truncate_index() noexcept
+        {
+#ifdef _WIN32
+            if (::_chsize_s(index_fd, static_cast<__int64>(index_size)) == 0) return;
+            ::_close(index_fd);
+#else
+            if (::ftruncate(index_fd, static_cast<off_t>(index_size)) == 0) return;
+            ::close(index_fd);
+#endif
+            index_fd = -1;
+        }
+
+        /**
+         * @brief Append the sealed entries. Writes are all or nothing, a partial entry would misalign those
+         * appended after it. Records of entries not written read as not indexed.
+         */
+        void write_index()
+        {
+            if (indexed.empty() || index_fd < 0)
+            {
+                indexed.clear();
+                return;
+            }
+            auto p = reinterpret_cast<const char*>(indexed.data());
+            auto size = indexed.size() * sizeof(index_entry);
+            indexed.clear();
+            for (auto n = size; n > 0;)
+            {
+#ifdef _WIN32
+                auto w = ::_write(index_fd, p, static_cast<unsigned>(std::min<std::size_t>(n, INT_MAX)));
+#else
+                auto w = ::write(index_fd, p, n);
+                if (w < 0 && errno == EINTR) continue;
+#endif
+                if (w <= 0)
+                {
+                    truncate_index();
+                    return;
+                }
+                p += w;
+                n -= static_cast<std::size_t>(w);
+            }
+            index_size += size;
+        }
+
+        void run()
+        {
+            set_thread_name("ing-batch-sink");
+
+            std::unique_lock lock(mutex);
+            while (!stopping)
+            {
+                if (pending_records == 0)
+                    wakeup.wait(lock);
+                else if (wakeup.wait_until(lock, oldest + limits.latency) == std::cv_status::timeout)
+                    commit();
+            }
+        }
+
+    public:
+        batched_file_backend(std::string file, bool append, const policy& limits)
+            : file(std::move(file)), limits(limits)
+        {
+#ifdef _WIN32
+            fd = ::_open(this->file.c_str(), _O_WRONLY | _O_CREAT | _O_BINARY | (append ? _O_APPEND : _O_TRUNC), 0644);
+#else
+            fd = ::open(this->file.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC), 0644);
+#endif
+            if (fd < 0) throw std::system_error(errno, std::generic_category(), this->file);
+
+            if (limits.index_records || limits.index_bytes)
+            {
+                auto index_file = this->file + ".idx";
+#ifdef _WIN32
+                offset = static_cast<std::uint64_t>(::_lseeki64(fd, 0, SEEK_END));
+                index_fd = ::_open(index_file.c_str(), _O_RDWR | _O_CREAT | _O_BINARY | (append ? _O_APPEND : _O_TRUNC), 0644);
+#else
+                offset = static_cast<std::uint64_t>(::lseek(fd, 0, SEEK_END));
+                index_fd = ::open(index_file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC), 0644);
+#endif
+                if (index_fd < 0)
+                {
+                    auto err = errno;
+                    close();
+                    throw std::system_error(err, std::generic_category(), index_file);
+                }
+
+                index_file_header header{};
+#ifdef _WIN32
+                auto n = ::_read(index_fd, &header, sizeof(header));
+#else
+                auto n = ::read(index_fd, &header, sizeof(header));
+#endif
+                if (n == 0)
+                {
+                    std::memcpy(header.magic, index_magic, sizeof(index_magic));
+                    header.version = index_version;
+                    header.order = index_order;
+#ifdef _WIN32
+                    n = ::_write(index_fd, &header, sizeof(header));
+#else
+                    n = ::write(index_fd, &header, sizeof(header));
+#endif
+                }
+                else if (n != sizeof(header) || std::memcmp(header.magic, index_magic, sizeof(index_magic)) != 0 ||
+                         header.version != index_version || header.order != index_order)
+                {
+                    close();
+                    throw std::invalid_argument(index_file + " is not an index");
+                }
+
+                // A partial entry left by a crash during a write is cut off, so that the entries of this
+                // session stay aligned.
+#ifdef _WIN32
+                auto size = static_cast<std::uint64_t>(::_lseeki64(index_fd, 0, SEEK_END));
+#else
+                auto size = static_cast<std::uint64_t>(::lseek(index_fd, 0, SEEK_END));
+#endif
+                index_size = size - (size - std::min<std::uint64_t>(size, sizeof(header))) % sizeof(index_entry);
+                if (index_size != size) truncate_index();
+            }
+
+            if (limits.latency.count() > 0)
+                timer = std::thread(&batched_file_backend::run, this);
+        }
+
+        ~batched_file_backend()
+        {
+            {
+                std::lock_guard _(mutex);
+                stopping = true;
+                commit();
+            }
+            if (timer.joinable())
+            {
+                wakeup.notify_one();
+                timer.join();
+            }
+            seal();
+            write_index();
+            close();
+        }
+
+        void close() noexcept
+        {
+#ifdef _WIN32
+            ::_close(fd);
+            if (index_fd >= 0) ::_close(index_fd);
+#else
+            ::close(fd);
+            if (index_fd >= 0) ::close(index_fd);
+#endif
+        }
+
+        void consume(const boost::log::record_view& rec, const string_type& formatted)
+        {
+            const bool newline = formatted.empty() || formatted.back() != '\n';
+            const std::size_t n = formatted.size() + newline;
+
+            std::lock_guard _(mutex);
+            char* p = reserve(n);
+            std::memcpy(p, formatted.data(), formatted.size());
+            if (newline) p[formatted.size()] = '\n';
+
+            if (pending_records++ == 0)
+            {
+                oldest = std::chrono::steady_clock::now();
+                if (timer.joinable()) wakeup.notify_one();
+            }
+            pending_bytes += n;
+            if (index_fd >= 0) index(rec, n);
+            offset += n;
+
+            auto level = rec[expressions::severity];
+            if (pending_bytes >= limits.bytes || pending_records >= limits.records ||
+                (level && *level >= limits.severity))
+                commit();
+        }
+
+        void flush()
+        {
+            std::lock_guard _(mutex);
+            commit();
+        }
+
+        const std::string& file_name() const noexcept
+        {
+            return file;
+        }
+
+        void report(std::ostream& os) const
+        {
+            auto r = records.load(std::memory_order_relaxed);
+            auto b = bytes.load(std::memory_order_relaxed);
+            auto c = syscalls.load(std::memory_order_relaxed);
+            os << file << '\t' << r << '\t' << b << '\t' << c << '\t'
+               << (c ? static_cast<double>(r) / static_cast<double>(c) : 0.0) << '\t'
+               << failed_batches.load(std::memory_order_relaxed) << '\t'
+               << lost_records.load(std::memory_order_relaxed) << '\n';
+        }
+    };
+
+    /**
+     * @brief Batched file backends alive, for reporting.
+     */
+    class batched_file_registry
+    {
+        spinlock guard;
+        std::vector<boost::weak_ptr<batched_file_backend>> backends;
+
+    public:
+        static batched_file_registry& get()
+        {
+            static batched_file_registry& registry = *new batched_file_registry;
+            return registry;
+        }
+
+        void add(const boost::shared_ptr<batched_file_backend>& backend)
+        {
+            std::lock_guard _(guard);
+            backends.erase(std::remove_if(backends.begin(), backends.end(),
+                                          [](const auto& b) { return b.expired(); }), backends.end());
+            backends.push_back(backend);
+        }
+
+        std::vector<boost::shared_ptr<batched_file_backend>> snapshot()
+        {
+            std::vector<boost::shared_ptr<batched_file_backend>> alive;
+            std::lock_guard _(guard);
+            for (const auto& b : backends)
+                if (auto p = b.lock()) alive.push_back(std::move(p));
+            return alive;
+        }
+    };
+
+    void report(std::ostream& os)
+    {
+        boost::io::ios_flags_saver ifs(os);
+        boost::io::ios_precision_saver ips(os);
+        os.setf(std::ios_base::fixed, std::ios_base::floatfield);
+        os.precision(2);
+
+        os << "file" << '\t' << "records" << '\t' << "bytes" << '\t' << "syscalls" << '\t' << "records/syscall" << '\t'
+       << "failed batches" << '\t' << "lost records" << '\n';
+        for (const auto& backend : batched_file_registry::get().snapshot())
+            backend->report(os);
+    }
+
+    void query_index(const std::string& file, const index_query& query,
+                     const std::function<void(std::uint64_t offset, std::uint64_t size)>& visit)
+    {
+        auto index_file = file + ".idx";
+        std::ifstream in(index_file, std::ios_base::binary);
+        if (!in) throw std::invalid_argument("cannot open " + index_file);
+
+        index_file_header header;
+        if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, index_magic, sizeof(index_magic)) != 0 ||
+            header.version != index_version || header.order != index_order)
+            throw std::invalid_argument(index_file + " is not an index");
+
+        auto matches = [&query](const index_entry& e)
+        {
+            // Blocks without time stamps are kept, they cannot be ruled out.
+            if (e.first <= e.last && ((query.from && e.last < *query.from) || (query.to && e.first > *query.to)))
+                return false;
+            if (query.severity && (e.severities >> static_cast<unsigned>(*query.severity)) == 0)
+                return false;
+            if (!query.channels.empty() &&
+                std::none_of(query.channels.begin(), query.channels.end(),
+                             [&e](const std::string& channel) { return e.may_contain(channel); }))
+                return false;
+            return true;
+        };
+
+        // Adjacent ranges are visited as one. Ranges not indexed, e.g. written by a session without index
+        // or not committed yet, are always visited.
+        std::uint64_t first = 0, last = 0, end = 0;
+        auto emit = [&](std::uint64_t offset, std::uint64_t size)
+        {
+            if (offset != last)
+            {
+                if (last > first) visit(first, last - first);
+                first = offset;
+            }
+            last = offset + size;
+        };
+
+        // A trailing partial entry, e.g. of a crash during a write, is ignored, its records read as not indexed.
+        index_entry e;
+        while (in.read(reinterpret_cast<char*>(&e), sizeof(e)))
+        {
+            if (e.offset > end) emit(end, e.offset - end);
+            end = std::max(end, e.offset + e.size);
+            if (matches(e)) emit(e.offset, e.size);
+        }
+
+        std::error_code ec;
+        auto size = static_cast<std::uint64_t>(std::filesystem::file_size(file, ec));
+        if (ec) throw std::invalid_argument("cannot open " + file);
+        if (size > end) emit(end, size - end);
+        if (last > first) visit(first, last - first);
+    }
+
+    // Layout of files written by BinaryFile sinks, in the byte order of the writer. Entries follow the header
+    // and are padded to 8 bytes. Channels and call sites are defined by an entry before the first record
+    // referring to them, indices may be redefined by later sessions appended to the same file.
+    struct binary_file_header
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t order;
+        std::uint64_t end;  // size of the committed part, header included
+        char reserved[40];
+    };
+
+    struct binary_entry
+    {
+        enum type : std::uint8_t { channel = 1, callsite = 2, record = 3, format = 4, deferred = 5 };
+
+        std::uint32_t size;  // header included, padding excluded
+        std::uint8_t type;
+        std::uint8_t severity;
+        std::uint16_t reserved;
+    };
+
+    struct binary_channel_entry
+    {
+        binary_entry entry;
+        std::uint32_t index;
+        std::uint32_t length;
+    };
+
+    struct binary_callsite_entry
+    {
+        binary_entry entry;
+        std::uint32_t index;
+        std::uint32_t line;
+        std::uint32_t column;
+        std::uint32_t file;
+        std::uint32_t function;
+        std::uint32_t reserved;
+    };
+
+    struct binary_record_entry
+    {
+        binary_entry entry;
+        std::int64_t time;
+        std::uint32_t channel;
+        std::uint32_t callsite;
+        std::uint32_t length;
+        std::uint32_t reserved;
+    };
+
+    struct binary_format_entry
+    {
+        binary_entry entry;
+        std::uint32_t index;
+        std::uint32_t length;
+    };
+
+    // Record of a deferred message, the arguments tagged by argument_tag are followed by the suffix text.
+    struct binary_deferred_entry
+    {
+        binary_entry entry;
+        std::int64_t time;
+        std::uint32_t channel;
+        std::uint32_t callsite;
+        std::uint32_t format;
+        std::uint32_t arguments;
+    };
+
+    static constexpr char binary_magic[8] = { 'i', 'n', 'g', 'b', 'l', 'o', 'g', '\0' };
+    static constexpr std::uint32_t binary_version = 1;
+    static constexpr std::uint32_t binary_order = 0x01020304;
+    static constexpr std::uint32_t binary_none = 0xffffffff;
+    static constexpr std::uint8_t binary_no_severity = 0xff;
+    static constexpr std::int64_t binary_no_time = INT64_MIN;
+
+    static_assert(sizeof(binary_file_header) == 64);
+    static_assert(sizeof(binary_channel_entry) == 16);
+    static_assert(sizeof(binary_callsite_entry) == 32);
+    static_assert(sizeof(binary_record_entry) == 32);
+    static_assert(sizeof(binary_format_entry) == 16);
+    static_assert(sizeof(binary_deferred_entry) == 32);
+
+    /**
+     * @brief Argument of a deferred message decoded from its tagged binary form.
+     */
+    struct binary_argument
+    {
+        argument_tag tag;
+        std::uint64_t bits;  // the value, or the representation of a double
+    };
+
+    static bool decode_arguments(std::string_view bytes, std::vector<binary_argument>& args)
+    {
+        args.clear();
+        for (std::size_t i = 0; i < bytes.size();)
+        {
+            binary_argument arg{ static_cast<argument_tag>(bytes[i++]), 0 };
+            std::size_t n = arg.tag == char_tag || arg.tag == bool_tag ? 1 : 8;
+            if (arg.tag != signed_tag && arg.tag != unsigned_tag && arg.tag != floating_tag && n == 8) return false;
+            if (bytes.size() - i < n) return false;
+            if (n == 1) arg.bits = static_cast<unsigned char>(bytes[i]);
+            else std::memcpy(&arg.bits, bytes.data() + i, n);
+            i += n;
+            args.push_back(arg);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Format an argument by a standard format specification of fmt, [[fill]align][sign][#][0][width]
+     * [.precision][type]. Return false for what the binary form cannot tell, e.g. dynamic width or locale.
+     */
+    static bool format_argument(std::string& out, const binary_argument& arg, std::string_view spec)
+    {
+        char fill = ' ', align = 0, sign = '-', type = 0;
+        bool alternate = false, zero = false;
+        std::size_t width = 0;
+        int precision = -1;
+
+        std::size_t i = 0;
+        auto is_align = [](char c) { return c == '<' || c == '>' || c == '^'; };
+        if (spec.size() >= 2 && is_align(spec[1]))
+        {
+            if (spec[0] == '{' || spec[0] == '}' || static_cast<unsigned char>(spec[0]) >= 0x80) return false;
+            fill = spec[0];
+            align = spec[1];
+            i = 2;
+        }
+        else if (!spec.empty() && is_align(spec[0]))
+        {
+            align = spec[0];
+            i = 1;
+        }
+        if (i < spec.size() && (spec[i] == '+' || spec[i] == '-' || spec[i] == ' ')) sign = spec[i++];
+        if (i < spec.size() && spec[i] == '#') alternate = (++i, true);
+        if (i < spec.size() && spec[i] == '0') zero = (++i, true);
+        auto number = [&spec, &i](auto& value)
+        {
+            auto [end, ec] = std::from_chars(spec.data() + i, spec.data() + spec.size(), value);
+            if (ec != std::errc()) return false;
+            i = static_cast<std::size_t>(end - spec.data());
+            return true;
+        };
+        if (i < spec.size() && spec[i] >= '1' && spec[i] <= '9' && !number(width)) return false;
+        if (i < spec.size() && spec[i] == '.' && (++i, !number(precision))) return false;
+        if (i < spec.size()) type = spec[i++];
+        if (i != spec.size()) return false;
+
+        // The digits and the sign or prefix they are padded after with zeros.
+        std::string prefix;
+        std::string digits;
+        char buf[128];
+        bool numeric = true;
+
+        auto integer = [&](std::uint64_t magnitude, bool negative)
+        {
+            int base = 10;
+            switch (type)
+            {
+            case 0: case 'd': break;
+            case 'x': case 'X': base = 16; break;
+            case 'o': base = 8; break;
+            case 'b': case 'B': base = 2; break;
+            default: return false;
+            }
+            if (precision >= 0) return false;
+            if (negative) prefix = "-";
+            else if (sign != '-') prefix = sign;
+            if (alternate && base != 10)
+                prefix += base == 16 ? (type == 'X' ? "0X" : "0x") : base == 2 ? (type == 'B' ? "0B" : "0b") : "0";
+            digits.assign(buf, std::to_chars(buf, buf + sizeof(buf), magnitude, base).ptr);
+            if (type == 'X')
+                std::transform(digits.begin(), digits.end(), digits.begin(), [](char c) { return std::toupper(c); });
+            if (base == 8 && alternate && magnitude == 0) prefix.pop_back();
+            return true;
+        };
+
+        switch (arg.tag)
+        {
+        case signed_tag:
+        case unsigned_tag:
+        {
+            bool negative = arg.tag == signed_tag && static_cast<std::int64_t>(arg.bits) < 0;
+            auto magnitude = negative ? ~arg.bits + 1 : arg.bits;
+            if (type == 'c')
+            {
+                if (precision >= 0 || sign != '-' || alternate || zero) return false;
+                digits.assign(1, static_cast<char>(arg.bits));
+                numeric = false;
+            }
+            else if (!integer(magnitude, negative))
+                return false;
+            break;
+        }
+        case char_tag:
+        case bool_tag:
+            if (type == 0 || type == (arg.tag == char_tag ? 'c' : 's'))
+            {
+                if (precision >= 0 || sign != '-' || alternate || zero) return false;
+                if (arg.tag == char_tag) digits.assign(1, static_cast<char>(arg.bits));
+                else digits = arg.bits ? "true" : "false";
+                numeric = false;
+            }
+            else if (!integer(arg.bits, false))
+                return false;
+            break;
+        case floating_tag:
+        {
+            double v;
+            std::memcpy(&v, &arg.bits, sizeof(v));
+            if (alternate) return false;
+            if (std::signbit(v)) prefix = "-";
+            else if (sign != '-') prefix = sign;
+            v = std::fabs(v);
+#if __cpp_lib_to_chars >= 201611L
+            std::to_chars_result r;
+            switch (type)
+            {
+            case 0:
+                if (precision >= 0)
+                {
+                    r = std::to_chars(buf, buf + sizeof(buf), v, std::chars_format::general, precision);
+                    break;
+                }
+                // Shortest representation, fixed for exponents from -4 to 15 like fmt.
+                r = std::to_chars(buf, buf + sizeof(buf), v, std::chars_format::scientific);
+                if (r.ec == std::errc() && std::isfinite(v))
+                {
+                    int exponent = 0;
+                    auto e = std::find(buf, r.ptr, 'e');
+                    std::from_chars(e + (e[1] == '+' ? 2 : 1), r.ptr, exponent);
+                    if (exponent >= -4 && exponent < 16)
+                        r = std::to_chars(buf, buf + sizeof(buf), v, std::chars_format::fixed);
+                }
+                break;
+            case 'e': case 'E':
+                r = std::to_chars(buf, buf + sizeof(buf), v, std::chars_format::scientific, precision < 0 ? 6 : precision);
+                break;
+            case 'f': case 'F':
+                r = std::to_chars(buf, buf + sizeof(buf), v, std::chars_format::fixed, precision < 0 ? 6 : precision);
+                break;
+            case 'g': case 'G':
+                r = std::to_chars(buf, buf + sizeof(buf), v, std::chars_format::general, precision < 0 ? 6 : precision);
+                break;
+            case 'a': case 'A':
+                r = precision < 0 ? std::to_chars(buf, buf + sizeof(buf), v, std::chars_format::hex)
+                                  : std::to_chars(buf, buf + sizeof(buf), v, std::chars_format::hex, precision);
+                if (std::isfinite(v)) prefix += type == 'A' ? "0X" : "0x";
+                break;
+            default:
+                return false;
+            }
+            if (r.ec != std::errc()) return false;
+            digits.assign(buf, r.ptr);
+#else
+            if (type == 0 && precision < 0) return false;
+            char conversion = type == 0 ? 'g' : type;
+            if (!std::strchr("eEfFgGaA", conversion)) return false;
+            const char format[] = { '%', '.', '*', conversion, 0 };
+            int n = std::snprintf(buf, sizeof(buf), format, precision < 0 ? 6 : precision, v);
+            if (n < 0 || n >= static_cast<int>(sizeof(buf))) return false;
+            digits.assign(buf, static_cast<std::size_t>(n));
+            if (conversion == 'a' || conversion == 'A') digits.erase(0, 2), prefix += conversion == 'A' ? "0X" : "0x";
+#endif
+            if (type >= 'A' && type <= 'Z')
+                std::transform(digits.begin(), digits.end(), digits.begin(), [](char c) { return std::toupper(c); });
+            if (!std::isfinite(v)) zero = false;
+            break;
+        }
+        default:
+            return false;
+        }
+
+        std::size_t size = prefix.size() + digits.size();
+        std::size_t padding = width > size ? width - size : 0;
+        if (zero && numeric && !align)
+        {
+            out.append(prefix).append(padding, '0').append(digits);
+            return true;
+        }
+        if (!align) align = numeric ? '>' : '<';
+        std::size_t before = align == '>' ? padding : align == '^' ? padding / 2 : 0;
+        out.append(before, fill).append(prefix).append(digits).append(padding - before, fill);
+        return true;
+    }
+
+    /**
+     * @brief Format a deferred message when it is read, replacement fields are those of fmt without named or
+     * nested arguments. Return false if the format string is not supported, the caller then falls back.
+     */
+    static bool format_arguments(std::string& out, std::string_view format, const std::vector<binary_argument>& args)
+    {
+        std::size_t next = 0;
+        bool automatic = false, manual = false;
+        for (std::size_t i = 0; i < format.size();)
+        {
+            char c = format[i];
+            if (c == '}')
+            {
+                if (i + 1 >= format.size() || format[i + 1] != '}') return false;
+                out.push_back('}');
+                i += 2;
+                continue;
+            }
+            if (c != '{')
+            {
+                auto end = std::min(format.find_first_of("{}", i), format.size());
+                out.append(format.substr(i, end - i));
+                i = end;
+                continue;
+            }
+            if (i + 1 < format.size() && format[i + 1] == '{')
+            {
+                out.push_back('{');
+                i += 2;
+                continue;
+            }
+
+            auto close = format.find_first_of("{}", i + 1);
+            if (close == std::string_view::npos || format[close] != '}') return false;
+            auto field = format.substr(i + 1, close - i - 1);
+            auto colon = std::min(field.find(':'), field.size());
+            auto id = field.substr(0, colon);
+            std::size_t index = 0;
+            if (id.empty())
+            {
+                automatic = true;
+                index = next++;
+            }
+            else
+            {
+                manual = true;
+                auto [end, ec] = std::from_chars(id.data(), id.data() + id.size(), index);
+                if (ec != std::errc() || end != id.data() + id.size()) return false;
+            }
+            if ((automatic && manual) || index >= args.size()) return false;
+            if (!format_argument(out, args[index], colon < field.size() ? field.substr(colon + 1) : std::string_view()))
+                return false;
+            i = close + 1;
+        }
+        return true;
+    }
+
+#ifndef _WIN32
+    /**
+     * @brief File sink backend appending records in a compact binary form to a memory-mapped file that is
+     * pre-allocated in extents. Deferred fmt messages are stored as their format string and arguments, so that
+     * they are formatted when read, e.g. by ing_logcat. Other messages are stored as text.
+     */
+    class binary_file_backend : public boost::log::sinks::basic_sink_backend<boost::log::sinks::synchronized_feeding>
+    {
+        const std::string file;
+        const std::size_t extent;
+        int fd = -1;
+        char* base = nullptr;
+        std::size_t capacity = 0;
+        std::size_t end = 0;
+
+        std::unordered_map<const interned_channel*, std::uint32_t> channels;
+        std::vector<bool> callsites;
+        // Format strings are constants, they are told apart by their address.
+        std::unordered_map<const char*, std::pair<std::size_t, std::uint32_t>> formats;
+        std::uint32_t format_count = 0;
+        std::string arguments;
+        std::vector<binary_argument> decoded;
+
+        /**
+         * @brief Grows the file and maps it again. The previous mapping is released only once the new one is in
+         * place, so that a failure leaves the sink writing into the previous one.
+         */
+        void map(std::size_t size)
+        {
+            if (::ftruncate(fd, static_cast<off_t>(size)) != 0)
+                throw std::system_error(errno, std::generic_category(), file);
+#ifdef __linux__
+            // Allocate the blocks up front, a full disk is then reported here rather than by SIGBUS.
+            if (int err = ::posix_fallocate(fd, 0, static_cast<off_t>(size)); err != 0 && err != EOPNOTSUPP && err != EINVAL)
+                throw std::system_error(err, std::generic_category(), file);
+#endif
+            void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED) throw std::system_error(errno, std::generic_category(), file);
+            if (base) ::munmap(base, capacity);
+            base = static_cast<char*>(p);
+            capacity = size;
+        }
+
+        template<typename Entry>
+        void append(Entry head, std::uint8_t type, std::initializer_list<std::string_view> strings)
+        {
+            std::size_t size = sizeof(Entry);
+            for (auto str : strings) size += str.size();
+            const std::size_t padded = (size + 7) & ~std::size_t(7);
+            if (end + padded > capacity)
+                map(capacity + std::max(extent, padded));
+
+            head.entry.size = static_cast<std::uint32_t>(size);
+            head.entry.type = type;
+            char* p = base + end;
+            std::memcpy(p, &head, sizeof(Entry));
+            p += sizeof(Entry);
+            for (auto str : strings)
+            {
+                std::memcpy(p, str.data(), str.size());
+                p += str.size();
+            }
+            std::memset(p, 0, padded - size);
+
+            // Publish the entry, a reader of the mapping never sees a partial one.
+            end += padded;
+            std::atomic_thread_fence(std::memory_order_release);
+            reinterpret_cast<binary_file_header*>(base)->end = end;
+        }
+
+        std::uint32_t channel_index(channel_name channel)
+        {
+            auto iter = channels.find(channel.handle());
+            if (iter != channels.end()) return iter->second;
+
+            binary_channel_entry head{};
+            head.index = static_cast<std::uint32_t>(channels.size());
+            head.length = static_cast<std::uint32_t>(channel.view().size());
+            append(head, binary_entry::channel, { channel.view() });
+            return channels.emplace(channel.handle(), head.index).first->second;
+        }
+
+        std::uint32_t callsite_index(callsite_id id)
+        {
+            auto n = static_cast<std::size_t>(id);
+            if (n >= callsites.size()) callsites.resize(n + 1);
+            if (!callsites[n])
+            {
+                const auto& loc = callsite_location(id);
+                std::string_view file = loc.file_name();
+                std::string_view function = loc.function_name();
+                binary_callsite_entry head{};
+                head.index = static_cast<std::uint32_t>(n);
+                head.line = loc.line();
+                head.column = loc.column();
+                head.file = static_cast<std::uint32_t>(file.size());
+                head.function = static_cast<std::uint32_t>(function.size());
+                append(head, binary_entry::callsite, { file, function });
+                callsites[n] = true;
+            }
+            return static_cast<std::uint32_t>(n);
+        }
+
+        /**
+         * @brief Index of the format string, binary_none if the reader cannot format it, which is found out once
+         * with the arguments of the first record.
+         */
+        std::uint32_t format_index(std::string_view format)
+        {
+            auto iter = formats.find(format.data());
+            if (iter != formats.end() && iter->second.first == format.size()) return iter->second.second;
+
+            std::string text;
+            if (!decode_arguments(arguments, decoded) || !format_arguments(text, format, decoded))
+            {
+                formats[format.data()] = { format.size(), binary_none };
+                return binary_none;
+            }
+
+            binary_format_entry head{};
+            head.index = format_count++;
+            head.length = static_cast<std::uint32_t>(format.size());
+            append(head, binary_entry::format, { format });
+            formats[format.data()] = { format.size(), head.index };
+            return head.index;
+        }
+
+    public:
+        binary_file_backend(std::string file, bool append, std::size_t extent)
+            : file(std::move(file)), extent(std::max<std::size_t>(extent, 4096))
+        {
+            fd = ::open(this->file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+            if (fd < 0) throw std::system_error(errno, std::generic_category(), this->file);
+
+            binary_file_header header{};
+            struct stat st;
+            if (append && ::fstat(fd, &st) == 0 && st.st_size > 0)
+            {
+                if (::pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+                    std::memcmp(header.magic, binary_magic, sizeof(binary_magic)) != 0 ||
+                    header.version != binary_version || header.order != binary_order ||
+                    header.end < sizeof(header) || header.end > static_cast<std::uint64_t>(st.st_size))
+                {
+                    ::close(fd);
+                    throw std::invalid_argument(this->file + " is not a binary log");
+                }
+                end = static_cast<std::size_t>(header.end);
+            }
+            else
+            {
+                std::memcpy(header.magic, binary_magic, sizeof(binary_magic));
+                header.version = binary_version;
+                header.order = binary_order;
+                header.end = end = sizeof(header);
+            }
+
+            try
+            {
+                map(end + this->extent);
+            }
+            catch (...)
+            {
+                ::close(fd);
+                throw;
+            }
+            std::memcpy(base, &header, sizeof(header));
+        }
+
+        ~binary_file_backend()
+        {
+            ::munmap(base, capacity);
+            // Release the extent not used.
+            (void) ::ftruncate(fd, static_cast<off_t>(end));
+            ::close(fd);
+        }
+
+        void consume(const boost::log::record_view& rec)
+        {
+            binary_record_entry head{};
+            auto level = rec[expressions::severity];
+            head.entry.severity = level ? static_cast<std::uint8_t>(*level) : binary_no_severity;
+            auto channel = rec[expressions::channel];
+            head.channel = channel ? channel_index(*channel) : binary_none;
+            auto location = rec[expressions::location];
+            head.callsite = location ? callsite_index(*location) : binary_none;
+            auto time = rec[expressions::timestamp];
+            head.time = time && !time->is_special()
+                    ? local_microseconds(*time)
+                    : binary_no_time;
+
+            // The arguments of a deferred message are stored instead of being formatted here.
+            bool deferred = false;
+            boost::log::visit<attributes::deferred_arguments>(boost::log::aux::default_attribute_names::message(),
+                    rec, [&](const attributes::deferred_arguments& args)
+            {
+                arguments.clear();
+                if (!args.encode(arguments)) return;
+                auto format = format_index(args.format_string());
+                if (format == binary_none) return;
+
+                binary_deferred_entry entry{};
+                entry.entry.severity = head.entry.severity;
+                entry.time = head.time;
+                entry.channel = head.channel;
+                entry.callsite = head.callsite;
+                entry.format = format;
+                entry.arguments = static_cast<std::uint32_t>(arguments.size());
+                append(entry, binary_entry::deferred, { arguments, args.suffix_text() });
+                deferred = true;
+            });
+            if (deferred) return;
+
+            std::string_view message;
+            if (auto text = rec[boost::log::expressions::smessage]) message = *text;
+            head.length = static_cast<std::uint32_t>(message.size());
+            append(head, binary_entry::record, { message });
+        }
+    };
+#endif
+
+    void read_binary_file(const std::string& file, const std::function<void(const binary_record&)>& visit)
+    {
+        std::ifstream in(file, std::ios_base::binary);
+        if (!in) throw std::invalid_argument("cannot open " + file);
+
+        binary_file_header header;
+        if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, binary_magic, sizeof(binary_magic)) != 0 ||
+            header.version != binary_version || header.order != binary_order || header.end < sizeof(header))
+            throw std::invalid_argument(file + " is not a binary log");
+
+        struct callsite
+        {
+            std::string file;
+            std::string function;
+            std::uint32_t line;
+            std::uint32_t column;
+        };
+        std::unordered_map<std::uint32_t, std::string> channels;
+        std::unordered_map<std::uint32_t, callsite> callsites;
+        std::unordered_map<std::uint32_t, std::string> formats;
+        std::vector<binary_argument> args;
+        std::string body;
+        std::string message;
+
+        auto corrupted = [&file] { return std::invalid_argument(file + " is corrupted"); };
+        auto text = [&body](std::size_t offset, std::size_t length) { return std::string_view(body).substr(offset, length); };
+        auto record = [&](const binary_entry& entry, std::int64_t time, std::uint32_t channel, std::uint32_t site,
+                          std::string_view message)
+        {
+            binary_record rec;
+            if (time != binary_no_time) rec.time = time;
+            if (entry.severity != binary_no_severity) rec.severity = static_cast<severity_level>(entry.severity);
+            if (channel != binary_none)
+            {
+                auto iter = channels.find(channel);
+                if (iter == channels.end()) throw corrupted();
+                rec.channel = iter->second;
+            }
+            if (site != binary_none)
+            {
+                auto iter = callsites.find(site);
+                if (iter == callsites.end()) throw corrupted();
+                const auto& c = iter->second;
+                rec.location = source_location{{ c.file.c_str(), c.line, c.function.c_str(), c.column }};
+            }
+            rec.message = message;
+            return rec;
+        };
+
+        for (std::uint64_t offset = sizeof(header); offset < header.end;)
+        {
+            binary_entry entry;
+            if (header.end - offset < sizeof(entry) || !in.read(reinterpret_cast<char*>(&entry), sizeof(entry)))
+                throw corrupted();
+            const std::uint64_t padded = (std::uint64_t(entry.size) + 7) & ~std::uint64_t(7);
+            if (entry.size < sizeof(entry) || padded > header.end - offset)
+                throw corrupted();
+            body.resize(static_cast<std::size_t>(padded));
+            std::memcpy(body.data(), &entry, sizeof(entry));
+            if (!in.read(body.data() + sizeof(entry), static_cast<std::streamsize>(padded - sizeof(entry))))
+                throw corrupted();
+            offset += padded;
+
+            switch (entry.type)
+            {
+            case binary_entry::channel:
+            {
+                binary_channel_entry head;
+                if (entry.size < sizeof(head)) throw corrupted();
+                std::memcpy(&head, body.data(), sizeof(head));
+                if (entry.size - sizeof(head) < head.length) throw corrupted();
+                channels[head.index] = text(sizeof(head), head.length);
+                break;
+            }
+            case binary_entry::callsite:
+            {
+                binary_callsite_entry head;
+                if (entry.size < sizeof(head)) throw corrupted();
+                std::memcpy(&head, body.data(), sizeof(head));
+                if (entry.size - sizeof(head) < std::uint64_t(head.file) + head.function) throw corrupted();
+                callsites[head.index] = { std::string(text(sizeof(head), head.file)),
+                                          std::string(text(sizeof(head) + head.file, head.function)),
+                                          head.line, head.column };
+                break;
+            }
+            case binary_entry::record:
+            {
+                binary_record_entry head;
+                if (entry.size < sizeof(head)) throw corrupted();
+                std::memcpy(&head, body.data(), sizeof(head));
+                if (entry.size - sizeof(head) < head.length) throw corrupted();
+
+                visit(record(entry, head.time, head.channel, head.callsite, text(sizeof(head), head.length)));
+                break;
+            }
+            case binary_entry::format:
+            {
+                binary_format_entry head;
+                if (entry.size < sizeof(head)) throw corrupted();
+                std::memcpy(&head, body.data(), sizeof(head));
+                if (entry.size - sizeof(head) < head.length) throw corrupted();
+                formats[head.index] = text(sizeof(head), head.length);
+                break;
+            }
+            case binary_entry::deferred:
+            {
+                binary_deferred_entry head;
+                if (entry.size < sizeof(head)) throw corrupted();
+                std::memcpy(&head, body.data(), sizeof(head));
+                if (entry.size - sizeof(head) < head.arguments) throw corrupted();
+                auto iter = formats.find(head.format);
+                if (iter == formats.end()) throw corrupted();
+                auto arguments = text(sizeof(head), head.arguments);
+                if (!decode_arguments(arguments, args)) throw corrupted();
+
+                // A format string the reader cannot apply is kept as is, followed by the arguments.
+                message.clear();
+                if (!format_arguments(message, iter->second, args))
+                {
+                    message.assign(iter->second);
+                    for (const auto& arg : args)
+                    {
+                        message.push_back(' ');
+                        format_argument(message, arg, {});
+                    }
+                }
+                message.append(text(sizeof(head) + head.arguments, entry.size - sizeof(head) - head.arguments));
+                visit(record(entry, head.time, head.channel, head.callsite, message));
+                break;
+            }
+            default:
+                // Entry types added later are skipped.
+                break;
+            }
+        }
+    }
+
+    std::size_t replay_binary_file(const std::string& file, const std::function<bool(const binary_record&)>& filter)
+    {
+        // Call site strings must be static, they are kept for the rest of the process.
+        static spinlock guard;
+        static std::set<std::string>& strings = *new std::set<std::string>;
+        auto persist = [](const char* str)
+        {
+            std::lock_guard _(guard);
+            return strings.emplace(str).first->c_str();
+        };
+
+        auto core = boost::log::core::get();
+        std::size_t count = 0;
+        read_binary_file(file, [&](const binary_record& rec)
+        {
+            if (filter && !filter(rec)) return;
+
+            boost::log::attribute_set attrs;
+            if (rec.time)
+                attrs.insert(expressions::timestamp_type::get_name(),
+                             boost::log::attributes::constant<expressions::timestamp_type::value_type>(
+                                     boost::posix_time::ptime(boost::gregorian::date(1970, 1, 1)) +
+                                     boost::posix_time::microseconds(*rec.time)));
+            if (rec.severity)
+                attrs.insert(expressions::severity_type::get_name(),
+                             boost::log::attributes::constant<severity_level>(*rec.severity));
+            if (rec.channel)
+                attrs.insert(expressions::channel_type::get_name(),
+                             boost::log::attributes::constant<channel_name>(channel_name(*rec.channel)));
+            if (rec.location)
+            {
+                source_location loc = *rec.location;
+                loc.file_name(persist(loc.file_name())).function_name(persist(loc.function_name()));
+                attrs.insert(expressions::location_type::get_name(),
+                             boost::log::attributes::constant<callsite_id>(register_callsite(loc)));
+            }
+
+            if (auto record = core->open_record(attrs))
+            {
+                record.attribute_values().insert(expressions::names::message(),
+                        boost::log::attributes::make_attribute_value(std::string(rec.message)));
+                core->push_record(std::move(record));
+                ++count;
+            }
+        });
+        return count;
+    }
+
+    /**
+     * @brief Queueing strategy of the asynchronous sinks built by init_logging. Once the queue holds capacity
+     * records, the overflow policy either blocks the producer or drops a record. Dropped records are counted
+     * per channel, and the losses are reported by a warning record queued at most once per summary interval, on the
+     * channel ing.logging unless the filters reject it.
+     */
+    class overflow_queue
+    {
+    public:
+        enum overflow_policy { block, drop_newest, drop_oldest, drop_below };
+
+        struct policy
+        {
+            std::size_t capacity = 0;                   // 0 for no bound
+            overflow_policy overflow = block;
+            severity_level severity = severity_level::warn;  // records below are dropped by drop_below
+            std::chrono::steady_clock::duration interval = std::chrono::seconds(10);
+        };
+
+        void configure(const policy& limits)
+        {
+            std::lock_guard _(guard);
+            this->limits = limits;
+        }
+
+        /**
+         * @brief Report the queue depth and the time the backend takes per record to the meter.
+         */
+        void attach(std::shared_ptr<metrics::sink_meter> m)
+        {
+            std::lock_guard _(guard);
+            meter = std::move(m);
+        }
+
+    protected:
+        overflow_queue() = default;
+        template<typename ArgsT>
+        explicit overflow_queue(const ArgsT&) {}
+
+        void enqueue(const boost::log::record_view& rec)
+        {
+            std::unique_lock lock(guard);
+            if (limits.capacity && queue.size() >= limits.capacity)
+            {
+                auto overflow = limits.overflow;
+                if (overflow == drop_below)
+                {
+                    auto level = rec[expressions::severity];
+                    overflow = level && *level >= limits.severity ? block : drop_newest;
+                }
+                switch (overflow)
+                {
+                case drop_newest:
+                    drop(rec);
+                    return;
+                case drop_oldest:
+                    drop(queue.front());
+                    queue.pop_front();
+                    break;
+                default:
+                    space.wait(lock, [this] { return queue.size() < limits.capacity; });
+                    break;
+                }
+            }
+            push(rec);
+        }
+
+        bool try_enqueue(const boost::log::record_view& rec)
+        {
+            std::unique_lock lock(guard, std::try_to_lock);
+            if (!lock || (limits.capacity && queue.size() >= limits.capacity)) return false;
+            push(rec);
+            return true;
+        }
+
+        bool try_dequeue_ready(boost::log::record_view& rec)
+        {
+            return try_dequeue(rec);
+        }
+
+        bool try_dequeue(boost::log::record_view& rec)
+        {
+            std::unique_lock lock(guard);
+            written();
+            summarize(lock);
+            return pop(rec);
+        }
+
+        bool dequeue_ready(boost::log::record_view& rec)
+        {
+            std::unique_lock lock(guard);
+            written();
+            while (!interrupted)
+            {
+                summarize(lock);
+                if (pop(rec)) return true;
+                if (lost.empty()) ready.wait(lock);
+                else ready.wait_until(lock, last + limits.interval);
+            }
+            interrupted = false;
+            return false;
+        }
+
+        void interrupt_dequeue()
+        {
+            std::lock_guard _(guard);
+            interrupted = true;
+            ready.notify_one();
+        }
+
+    private:
+        struct loss
+        {
+            std::uint64_t records = 0;
+            std::uint64_t bytes = 0;
+        };
+
+        std::mutex guard;
+        std::condition_variable ready;
+        std::condition_variable space;
+        std::deque<boost::log::record_view> queue;
+        bool interrupted = false;
+        policy limits;
+        std::map<std::string_view, loss> lost;
+        channel_name dropped_channel;  // of the last dropped record, accepted by this sink
+        severity_level dropped_level = severity_level::warn;
+        std::chrono::steady_clock::time_point last = std::chrono::steady_clock::now();
+        std::shared_ptr<metrics::sink_meter> meter;
+        std::chrono::steady_clock::time_point handed;  // when the record being written was dequeued
+
+        void push(const boost::log::record_view& rec)
+        {
+            queue.push_back(rec);
+            if (meter) meter->depth.store(queue.size(), std::memory_order_relaxed);
+            if (queue.size() == 1) ready.notify_one();
+        }
+
+        bool pop(boost::log::record_view& rec)
+        {
+            if (queue.empty()) return false;
+            rec.swap(queue.front());
+            queue.pop_front();
+            space.notify_one();
+            if (meter)
+            {
+                meter->depth.store(queue.size(), std::memory_order_relaxed);
+                if (metrics::collecting.load(std::memory_order_relaxed))
+                    handed = std::chrono::steady_clock::now();
+            }
+            return true;
+        }
+
+        // The consumer asks for the next record once the previous one is written.
+        void written()
+        {
+            if (handed == std::chrono::steady_clock::time_point()) return;
+            meter->record(std::chrono::steady_clock::now() - handed);
+            handed = {};
+        }
+
+        void drop(const boost::log::record_view& rec)
+        {
+            auto channel = rec[expressions::channel];
+            const interned_channel* entry = channel ? channel->handle() : channel_name().handle();
+            dropped_channel = channel ? *channel : channel_name();
+            auto level = rec[expressions::severity];
+            dropped_level = level ? *level : severity_level::warn;
+            auto message = rec[boost::log::expressions::smessage];
+            std::uint64_t bytes = message ? message->size() : 0;
+            entry->dropped_records.fetch_add(1, std::memory_order_relaxed);
+            entry->dropped_bytes.fetch_add(bytes, std::memory_order_relaxed);
+            auto& l = lost[entry->name];
+            l.records += 1;
+            l.bytes += bytes;
+        }
+
+        // Queue the summary of the records dropped since the last one, the lock is released meanwhile.
+        void summarize(std::unique_lock<std::mutex>& lock)
+        {
+            auto now = std::chrono::steady_clock::now();
+            if (lost.empty() || now - last < limits.interval) return;
+            last = now;
+            std::map<std::string_view, loss> losses;
+            losses.swap(lost);
+            lock.unlock();
+
+            loss total;
+            std::string detail;
+            for (const auto& [channel, l] : losses)
+            {
+                total.records += l.records;
+                total.bytes += l.bytes;
+                detail.append(detail.empty() ? " (" : ", ")
+                      .append(channel).append(": ")
+                      .append(std::to_string(l.records)).append(" records, ")
+                      .append(std::to_string(l.bytes)).append(" bytes");
+            }
+            detail.append(")");
+
+            // Records can only be opened through the filters of the core. Should no sink accept the channel
+            // ing.logging, the summary takes the channel and severity of a dropped record, which this sink accepted.
+            auto open = [](channel_name channel, severity_level level)
+            {
+                boost::log::attribute_set attrs;
+                attrs.insert(expressions::severity_type::get_name(),
+                             boost::log::attributes::constant<severity_level>(level));
+                attrs.insert(expressions::channel_type::get_name(),
+                             boost::log::attributes::constant<channel_name>(channel));
+                return boost::log::core::get()->open_record(attrs);
+            };
+            auto record = open(channel_name("ing.logging"), severity_level::warn);
+            if (!record)
+            {
+                lock.lock();
+                auto channel = dropped_channel;
+                auto level = dropped_level;
+                lock.unlock();
+                record = open(channel, std::max(level, severity_level::warn));
+                if (!record) record = open(channel, level);
+            }
+            if (record)
+            {
+                record.attribute_values().insert(expressions::names::message(),
+                        boost::log::attributes::make_attribute_value(
+                                "sink queue overflowed, dropped " + std::to_string(total.records) + " records, " +
+                                std::to_string(total.bytes) + " bytes" + detail));
+            }
+
+            lock.lock();
+            // Bypasses the capacity, the consumer is the caller.
+            if (record)
+            {
+                push(record.lock());
+                return;
+            }
+            // Kept for the next summary rather than lost if the core filters out the record.
+            for (const auto& [channel, l] : losses)
+            {
+                auto& kept = lost[channel];
+                kept.records += l.records;
+                kept.bytes += l.bytes;
+            }
+        }
+    };
+
+    /**
+     * @brief Asynchronous frontend feeding its backend from a named worker thread of its own. Producers only
+     * queue the record view, so a slow sink holds up neither them nor the other sinks until its queue is full.
+     */
+    template<typename Backend>
+    class worker_sink final : public boost::log::sinks::asynchronous_sink<Backend, overflow_queue>
+    {
+        using base_type = boost::log::sinks::asynchronous_sink<Backend, overflow_queue>;
+
+        std::atomic<bool> done{false};
+        std::thread worker;
+
+    public:
+        worker_sink(const boost::shared_ptr<Backend>& backend, const overflow_queue::policy& limits, std::string_view name)
+            : base_type(backend, false)
+        {
+            this->configure(limits);
+            worker = std::thread([this, name = ing::string(name)]() mutable
+            {
+                set_thread_name(std::move(name));
+                this->run();
+                done.store(true, std::memory_order_release);
+            });
+        }
+
+        ~worker_sink()
+        {
+            // Stopping is a no-op until the worker runs the feeding loop.
+            while (!done.load(std::memory_order_acquire))
+            {
+                this->stop();
+                std::this_thread::yield();
+            }
+            worker.join();
+        }
+    };
+
+    struct route
+    {
+        boost::shared_ptr<boost::log::sinks::sink> sink;
+        std::shared_ptr<metrics::sink_meter> meter;  // timing synchronous sinks, asynchronous ones time themselves
+        bool routed = false;  // its filter refers to Channel and Severity only, if at all
+    };
+
+    /**
+     * @brief Sinks of a router, with the routed sinks accepting each channel and severity looked up per record
+     * instead of evaluating their filters. The row of a channel is filled once the channel is first logged,
+     * by evaluating the filters with the channel and each severity. The other sinks, and records of channels
+     * beyond the table or without a channel or severity, are filtered per record.
+     */
+    class route_table
+    {
+        static constexpr std::size_t severities = 6;
+        static constexpr std::size_t chunk = 64;
+        static constexpr std::size_t chunks = 1024;
+
+        struct row
+        {
+            std::atomic<bool> ready;
+            std::atomic<std::uint64_t> accepted[severities];  // bit i for sinks[i]
+        };
+
+        mutable std::atomic<row*> rows[chunks] = {};
+        std::uint64_t routed = 0;
+        std::vector<std::size_t> filtered;
+
+        static std::size_t next(std::uint64_t& mask) noexcept
+        {
+#ifdef _MSC_VER
+            unsigned long i;
+            _BitScanForward64(&i, mask);
+#else
+            auto i = __builtin_ctzll(mask);
+#endif
+            mask &= mask - 1;
+            return static_cast<std::size_t>(i);
+        }
+
+        row* find(std::size_t id) const
+        {
+            if (id >= chunk * chunks) return nullptr;
+            auto& c = rows[id / chunk];
+            auto* p = c.load(std::memory_order_acquire);
+            if (!p)
+            {
+                auto* fresh = new row[chunk]();
+                if (c.compare_exchange_strong(p, fresh, std::memory_order_acq_rel)) p = fresh;
+                else delete[] fresh;
+            }
+            return p + id % chunk;
+        }
+
+        // Threads filling a row concurrently store the same masks.
+        void fill(row& r, channel_name channel) const
+        {
+            for (std::size_t level = 0; level < severities; ++level)
+            {
+                boost::log::attribute_set attrs;
+                attrs.insert(expressions::channel_type::get_name(),
+                             boost::log::attributes::constant<channel_name>(channel));
+                attrs.insert(expressions::severity_type::get_name(),
+                             boost::log::attributes::constant<severity_level>(static_cast<severity_level>(level)));
+                boost::log::attribute_value_set values(attrs, boost::log::attribute_set(), boost::log::attribute_set());
+                values.freeze();
+
+                std::uint64_t accepted = 0;
+                for (auto mask = routed; mask;)
+                {
+                    auto i = next(mask);
+                    if (sinks[i].sink->will_consume(values)) accepted |= std::uint64_t(1) << i;
+                }
+                r.accepted[level].store(accepted, std::memory_order_relaxed);
+            }
+            r.ready.store(true, std::memory_order_release);
+        }
+
+        // Routed sinks accepting the record, or null to filter all sinks.
+        const std::atomic<std::uint64_t>* lookup(const boost::log::attribute_value_set& values) const
+        {
+            if (!routed) return nullptr;
+            auto channel = values[expressions::channel];
+            auto level = values[expressions::severity];
+            if (!channel || !level) return nullptr;
+            auto* r = find(channel->handle()->id);
+            if (!r) return nullptr;
+            if (!r->ready.load(std::memory_order_acquire)) fill(*r, *channel);
+            return &r->accepted[static_cast<std::size_t>(*level)];
+        }
+
+    public:
+        const std::vector<route> sinks;
+
+        explicit route_table(std::vector<route> list) : sinks(std::move(list))
+        {
+            for (std::size_t i = 0; i < sinks.size(); ++i)
+            {
+                if (sinks[i].routed && i < 64) routed |= std::uint64_t(1) << i;
+                else filtered.push_back(i);
+            }
+        }
+
+        ~route_table()
+        {
+            for (auto& c : rows)
+                delete[] c.load(std::memory_order_relaxed);
+        }
+
+        bool accepts(const boost::log::attribute_value_set& values) const
+        {
+            const auto* accepted = lookup(values);
+            if (!accepted)
+            {
+                for (const auto& r : sinks)
+                    if (r.sink->will_consume(values)) return true;
+                return false;
+            }
+            if (accepted->load(std::memory_order_relaxed)) return true;
+            for (auto i : filtered)
+                if (sinks[i].sink->will_consume(values)) return true;
+            return false;
+        }
+
+        template<typename F>
+        void each(const boost::log::attribute_value_set& values, F f) const
+        {
+            const auto* accepted = lookup(values);
+            if (!accepted)
+            {
+                for (const auto& r : sinks)
+                    if (r.sink->will_consume(values)) f(r);
+                return;
+            }
+            for (auto mask = accepted->load(std::memory_order_relaxed); mask;)
+                f(sinks[next(mask)]);
+            for (auto i : filtered)
+                if (sinks[i].sink->will_consume(values)) f(sinks[i]);
+        }
+    };
+
+    /**
+     * @brief Sink standing in the core for the sinks configured by init_logging, so that a reload swaps them
+     * at once. Records are fed to the sinks current when they are pushed, thus a record opened before a reload
+     * and pushed after it is consumed by the new sinks rather than lost. There are two routers, as the core
+     * detaches records from their thread only for cross-thread sinks.
+     */
+    class router final : public boost::log::sinks::sink
+    {
+        spinlock guard;
+        std::shared_ptr<const route_table> current = std::make_shared<const route_table>(std::vector<route>());
+
+        std::shared_ptr<const route_table> snapshot()
+        {
+            std::lock_guard _(guard);
+            return current;
+        }
 
-                    void operator=(const char* s)
-                    {
-                        static_assert(sizeof(unbox) == sizeof(boost::log::string_literal));
+    public:
+        explicit router(bool cross_thread) : sink(cross_thread) {}
 
-                        str = s;
-                        len = boost::log::string_literal::traits_type::length(s);
-                    }
-                };
+        static const boost::shared_ptr<router>& get(bool cross_thread)
+        {
+            // Never destroyed, the core refers to them for good.
+            static auto& sync = *new boost::shared_ptr<router>(boost::make_shared<router>(false));
+            static auto& async = *new boost::shared_ptr<router>(boost::make_shared<router>(true));
+            return cross_thread ? async : sync;
+        }
 
-                using scope_entry = attributes::named_scope::scope_entry;
-                scope_entry entry({}, {}, loc->line(), scope_entry::function);
-                reinterpret_cast<unbox&>(entry.scope_name) = loc->function_name();
-                reinterpret_cast<unbox&>(entry.file_name) = loc->file_name();
-                formatter(strm, entry);
-            }
-        });
-    }
+        /**
+         * @brief Install the sinks and return the previous ones, which may still be consuming records.
+         */
+        std::shared_ptr<const route_table> swap(std::shared_ptr<const route_table> table)
+        {
+            std::lock_guard _(guard);
+            current.swap(table);
+            return table;
+        }
 
-    const auto reset_sgr = boost::phoenix::val("\033[39;49m");
+        bool will_consume(const boost::log::attribute_value_set& values) override
+        {
+            return snapshot()->accepts(values);
+        }
 
-    template<typename Keyword, std::size_t N>
-    auto sgr(const Keyword& keyword, const std::array<std::string, N>& table)
-    {
-        return boost::log::expressions::wrap_formatter(
-            [keyword, table](boost::log::record_view const& rec, boost::log::formatting_ostream& strm)
+        void consume(const boost::log::record_view& rec) override
+        {
+            snapshot()->each(rec.attribute_values(), [&rec](const route& r)
             {
-                if (const auto& level = rec[keyword])
+                if (r.meter && metrics::collecting.load(std::memory_order_relaxed))
                 {
-                    auto i = static_cast<int>(*level);
-                    if (i >= 0 && i < table.size() && !table[i].empty())
-                        strm << '\033' << '[' << table[i] << 'm';
+                    auto start = std::chrono::steady_clock::now();
+                    r.sink->consume(rec);
+                    r.meter->record(std::chrono::steady_clock::now() - start);
                 }
-            });
-    }
-
-    const auto strip_sgr = boost::log::expressions::wrap_formatter(
-        [](boost::log::record_view const&, boost::log::formatting_ostream& strm)
-        {
-            auto find = [](char* s)
-            {
-                char* b = nullptr;
-                char* e = nullptr;
-                while (*s)
+                else
                 {
-                    if (*s++ == '\033' && *s++ == '[')
-                    {
-                        b = s - 2;
-                        while (('0' <= *s && *s <= '9') || *s == ';') ++s;
-                        if (*s == 'm')
-                        {
-                            e = s + 1;
-                            break;
-                        }
-                    }
+                    r.sink->consume(rec);
                 }
-                return std::make_pair(b, e);
-            };
+            });
+        }
 
-            strm.flush();
+        void flush() override
+        {
+            for (const auto& r : snapshot()->sinks)
+                r.sink->flush();
+        }
+    };
 
-            if (std::string* s = strm.rdbuf()->storage())
+    /**
+     * @brief Retires the sinks at exit as a reload does, since the routers are never destroyed. Records queued
+     * for the backend thread are pushed first, then the sinks write what they batch or buffer and are released.
+     * Records logged afterwards, e.g. by destructors of other static objects, are dropped.
+     */
+    struct exit_retirement
+    {
+        ~exit_retirement()
+        {
+            async::global.stop();
+            std::lock_guard _(reload_guard());
+            for (bool cross_thread : { false, true })
             {
-                auto a = find(s->data());
-                if (a.second == nullptr) return;
-
-                while (true)
-                {
-                    auto b = find(a.second);
-
-                    if (b.second)
-                    {
-                        auto n = b.first - a.second;
-                        std::memmove(a.first, a.second, n);
-                        a.first += n;
-                        a.second = b.second;
-                    }
-                    else
-                    {
-                        s->erase(a.first - s->data(), a.second - a.first);
-                        break;
-                    }
-                }
+                auto sinks = router::get(cross_thread)->swap(std::make_shared<const route_table>(std::vector<route>()));
+                while (sinks.use_count() > 1)
+                    std::this_thread::yield();
+                for (const auto& r : sinks->sinks)
+                    r.sink->flush();
             }
-        });
+        }
+    } exit_retirement;
 }
 
 namespace ing::logging::setup
@@ -271,20 +3999,136 @@ namespace ing::logging::setup
 #define ARG(name) const std::string& name = (iter = args.find(#name)) != args.end() ? iter->second : this->name
 #define ARGF(name, F) const auto name = (iter = args.find(#name)) != args.end() ? F(iter->second) : this->name
 
-    // %Default%
+    /**
+     * @brief Whether the stream is attached to a terminal, which is the only place SGR sequences are emitted by default.
+     */
+    inline bool is_terminal(std::FILE* stream) noexcept
+    {
+#ifdef _WIN32
+        return _isatty(_fileno(stream)) != 0;
+#else
+        return isatty(fileno(stream)) != 0;
+#endif
+    }
+
+    /**
+     * @brief Disable SGR output of the %Default% and %SGR% placeholders in a formatter template.
+     */
+    std::string disable_sgr(const std::string& format)
+    {
+        static const std::regex with_args(R"(%(Default|SGR)\(([^)]+)\)%)");
+        static const std::regex without_args(R"(%(Default|SGR)%)");
+        return std::regex_replace(std::regex_replace(format, with_args, "%$1($2,sgr=0)%"), without_args, "%$1(sgr=0)%");
+    }
+
+    /**
+     * @brief Names of the attributes referred to by a filter or format, e.g. Channel by "%Channel% = db".
+     */
+    void scan_placeholders(const std::string& str, std::set<std::string>& names)
+    {
+        static const std::regex placeholder(R"(%(\w+)[%(])");
+        for (std::sregex_iterator i(str.begin(), str.end(), placeholder), end; i != end; ++i)
+            names.insert((*i)[1]);
+    }
+
+    /**
+     * @brief Whether the filter of a sink depends on the channel and severity of records only, so that the
+     * routers look the sink up rather than evaluating its filter per record.
+     */
+    bool routable(const boost::log::settings_section& sink)
+    {
+        std::set<std::string> names;
+        scan_placeholders(sink["Filter"].or_default(std::string()), names);
+        names.erase(expressions::channel_type::get_name().string());
+        names.erase(expressions::severity_type::get_name().string());
+        return names.empty();
+    }
+
+    /**
+     * @brief Names of the attributes referenced as %Name% or %Name(...)% by the formats and filters in the settings.
+     * Without sinks the default formatter is used, which references the same attributes as %Default%.
+     */
+    std::set<std::string> referenced_attributes(const boost::log::settings& settings)
+    {
+        std::set<std::string> names;
+        auto scan = [&names](const std::string& str) { scan_placeholders(str, names); };
+
+        if (auto filter = settings["Core"]["Filter"].get<std::string>()) scan(*filter);
+        if (auto sinks = settings["Sinks"].get_section())
+        {
+            for (const auto& sink : sinks.property_tree())
+            {
+                scan(sink.second.get("Format", std::string()));
+                scan(sink.second.get("Filter", std::string()));
+                // Binary records and index entries carry the time stamp of when records were logged.
+                auto destination = sink.second.get("Destination", std::string());
+                if (destination == "BinaryFile" || (destination == "BatchedFile" &&
+                    (sink.second.get("IndexRecords", 0ul) || sink.second.get("IndexBytes", 0ul))))
+                    names.insert(expressions::timestamp_type::get_name().string());
+            }
+        }
+        else
+        {
+            names.insert("Default");
+        }
+
+        if (names.count("Default"))
+        {
+            names.insert(expressions::timestamp_type::get_name().string());
+            names.insert(expressions::scope_type::get_name().string());
+        }
+        return names;
+    }
+
+    // https://www.boost.org/doc/libs/develop/libs/log/doc/html/log/extension/settings.html#log.extension.settings.adding_support_for_user_defined_types_to_the_filter_parser
+    // Channel = "db", Channel begins_with "db.", Channel matches "db\..*"
+    class channel_filter_factory final : public boost::log::basic_filter_factory<char, logging::channel_name>
+    {
+        boost::log::filter on_custom_relation(const boost::log::attribute_name& name, const string_type& rel, const string_type& arg) override
+        {
+            auto test = [name](auto predicate)
+            {
+                return boost::log::filter([name, predicate](const boost::log::attribute_value_set& values)
+                {
+                    auto channel = boost::log::extract<logging::channel_name>(name, values);
+                    return channel && predicate(channel->view());
+                });
+            };
+
+            if (rel == "begins_with")
+                return test([arg](std::string_view s) { return s.substr(0, arg.size()) == arg; });
+            if (rel == "ends_with")
+                return test([arg](std::string_view s) { return s.size() >= arg.size() && s.substr(s.size() - arg.size()) == arg; });
+            if (rel == "contains")
+                return test([arg](std::string_view s) { return s.find(arg) != std::string_view::npos; });
+            if (rel == "matches")
+                return test([re = std::regex(arg)](std::string_view s) { return std::regex_match(s.begin(), s.end(), re); });
+            return basic_filter_factory::on_custom_relation(name, rel, arg);
+        }
+
+        value_type parse_argument(const string_type& arg) override
+        {
+            return value_type(arg);
+        }
+    };
+
+    // %Default(sgr=1)%
     class default_formatter_factory final : public boost::log::formatter_factory<char>
     {
         formatter_type create_formatter(const boost::log::attribute_name& name, const args_map& args) override
         {
             (void) name;
-            (void) args;
-            return formatter;
+            args_map::const_iterator iter;
+            ARGF(sgr, boost::lexical_cast<bool>);
+            return sgr ? formatter : plain;
         }
 
         const formatter_type formatter;
+        const formatter_type plain;
+        const bool sgr = true;
 
     public:
-        explicit default_formatter_factory(formatter_type formatter) : formatter(formatter) {}
+        default_formatter_factory(formatter_type formatter, formatter_type plain) : formatter(formatter), plain(plain) {}
     };
 
     // https://www.boost.org/doc/libs/develop/libs/log/doc/html/log/detailed/expressions.html#log.detailed.expressions.formatters.date_time
@@ -297,7 +4141,7 @@ namespace ing::logging::setup
             args_map::const_iterator iter;
             ARG(format);
             return boost::log::expressions::stream
-                << boost::log::expressions::format_date_time(expressions::timestamp, format);
+                << expressions::format_timestamp(expressions::timestamp, format);
         }
 
     public:
@@ -369,7 +4213,7 @@ namespace ing::logging::setup
     };
 
     // https://en.wikipedia.org/wiki/ANSI_escape_code#SGR_(Select_Graphic_Rendition)_parameters
-    // %SGR(mode=reset|strip)%
+    // %SGR(mode=reset|strip, sgr=1)%
     class sgr_formatter_factory : public boost::log::formatter_factory<char>
     {
         formatter_type create_formatter(const boost::log::attribute_name& name, const args_map& args) override
@@ -377,23 +4221,387 @@ namespace ing::logging::setup
             (void) name;
             args_map::const_iterator iter;
             auto mode = (iter = args.find("mode")) != args.end() ? iter->second : "";
-            if (mode == "reset") return boost::log::expressions::stream
-                        << expressions::reset_sgr;
+            ARGF(sgr, boost::lexical_cast<bool>);
             if (mode == "strip") return boost::log::expressions::stream
                         << expressions::strip_sgr;
-            if (!mode.empty()) throw std::invalid_argument("invalid mode " + mode);
+            if (!mode.empty() && mode != "reset") throw std::invalid_argument("invalid mode " + mode);
+            if (!sgr) return boost::log::expressions::wrap_formatter(
+                        [](boost::log::record_view const&, boost::log::formatting_ostream&) {});
+            if (mode == "reset") return boost::log::expressions::stream
+                        << expressions::reset_sgr;
             return boost::log::expressions::stream
                     << expressions::sgr(expressions::severity, table);
         }
 
+        const bool sgr = true;
+
     public:
         std::array<std::string, 6> table;
     };
 
+    boost::log::sinks::auto_newline_mode auto_newline_mode_from_string(const std::string& mode)
+    {
+        if (mode == "Disabled") return boost::log::sinks::disabled_auto_newline;
+        else if (mode == "AlwaysInsert") return boost::log::sinks::always_insert;
+        else if (mode == "InsertIfMissing") return boost::log::sinks::insert_if_missing;
+        else throw std::invalid_argument("invalid AutoNewline " + mode);
+    }
+
+    sinks::overflow_queue::overflow_policy overflow_policy_from_string(const std::string& policy)
+    {
+        if (policy == "Block") return sinks::overflow_queue::block;
+        else if (policy == "DropNewest") return sinks::overflow_queue::drop_newest;
+        else if (policy == "DropOldest") return sinks::overflow_queue::drop_oldest;
+        else if (policy == "DropBelow") return sinks::overflow_queue::drop_below;
+        else throw std::invalid_argument("invalid Overflow " + policy);
+    }
+
+    // [Sinks.NAME]
+    // Asynchronous = false  # feed the backend from a worker thread of the sink
+    // ThreadName = ing-sink-NAME  # of the worker thread
+    // QueueCapacity = 0     # records the asynchronous sink may hold, 0 for no bound
+    // Overflow = Block      # Block, DropNewest, DropOldest or DropBelow once the queue is full
+    // OverflowSeverity = WARN     # records below are dropped and others block by DropBelow
+    // DropSummary = 10      # seconds between the warnings reporting the records dropped
+    // Filter = ...
+    // Format = ...          # for text sinks
+    template<typename Backend>
+    boost::shared_ptr<boost::log::sinks::sink> make_sink(const boost::log::settings_section& settings,
+                                                         const boost::shared_ptr<Backend>& backend)
+    {
+        auto init = [&settings](auto sink) -> boost::shared_ptr<boost::log::sinks::sink>
+        {
+            if (auto filter = settings["Filter"].get())
+                sink->set_filter(boost::log::parse_filter(*filter));
+            if constexpr (boost::log::sinks::has_requirement<typename Backend::frontend_requirements,
+                                                             boost::log::sinks::formatted_records>::value)
+            {
+                if (auto format = settings["Format"].get())
+                    sink->set_formatter(boost::log::parse_formatter(*format));
+            }
+            return sink;
+        };
+        if (settings["Asynchronous"].or_default(false))
+        {
+            sinks::overflow_queue::policy limits;
+            limits.capacity = settings["QueueCapacity"].or_default(limits.capacity);
+            if (auto overflow = settings["Overflow"].get())
+                limits.overflow = overflow_policy_from_string(*overflow);
+            if (auto severity = settings["OverflowSeverity"].get())
+                limits.severity = boost::lexical_cast<severity_level>(*severity);
+            limits.interval = std::chrono::seconds(settings["DropSummary"].or_default(10));
+            return init(boost::make_shared<sinks::worker_sink<Backend>>(
+                    backend, limits, settings["ThreadName"].or_default(std::string("ing-sink"))));
+        }
+        return init(boost::make_shared<boost::log::sinks::synchronous_sink<Backend>>(backend));
+    }
+
+    // Same keys as the Console destination of Boost.Log.
+    // [Sinks.NAME]
+    // Destination = Console
+    // AutoFlush = false
+    // AutoNewline = InsertIfMissing  # Disabled, AlwaysInsert or InsertIfMissing
+    class console_sink_factory final : public boost::log::sink_factory<char>
+    {
+    public:
+        boost::shared_ptr<boost::log::sinks::sink> create_sink(const settings_section& settings) override
+        {
+            auto backend = boost::make_shared<boost::log::sinks::text_ostream_backend>();
+            backend->add_stream(boost::shared_ptr<std::ostream>(&std::clog, boost::null_deleter()));
+            if (auto mode = settings["AutoNewline"].get())
+                backend->set_auto_newline_mode(auto_newline_mode_from_string(*mode));
+            backend->auto_flush(settings["AutoFlush"].or_default(false));
+            return make_sink(settings, backend);
+        }
+    };
+
+    // Same keys as the TextFile destination of Boost.Log.
+    // [Sinks.NAME]
+    // Destination = TextFile
+    // FileName = app_%N.log            # required, file name pattern
+    // RotationSize = 1048576           # rotate once the file reaches that many bytes
+    // RotationInterval = 3600          # rotate every that many seconds, or
+    // RotationTimePoint = "Mon 00:00:00" # rotate at "HH:MM:SS", "WEEKDAY HH:MM:SS" or "DAY HH:MM:SS"
+    // EnableFinalRotation = true
+    // AutoFlush = false
+    // AutoNewline = InsertIfMissing
+    // Append = false
+    // Target = logs                    # collect rotated files into that directory, with
+    // MaxSize = ...                    # total size,
+    // MinFreeSpace = ...               # free space on the drive,
+    // MaxFiles = ...                   # and number of files limits
+    // ScanForFiles = All               # or Matching, files already in the target directory
+    class text_file_sink_factory final : public boost::log::sink_factory<char>
+    {
+        static boost::log::sinks::file::rotation_at_time_point parse_time_point(const std::string& str)
+        {
+            namespace file = boost::log::sinks::file;
+            static const std::regex pattern(R"(^\s*(?:(\w+)\s+)?(\d{1,2}):(\d{1,2}):(\d{1,2})\s*$)");
+            std::smatch m;
+            if (!std::regex_match(str, m, pattern)) throw std::invalid_argument("invalid RotationTimePoint " + str);
+
+            auto hour = static_cast<unsigned char>(std::stoul(m[2]));
+            auto minute = static_cast<unsigned char>(std::stoul(m[3]));
+            auto second = static_cast<unsigned char>(std::stoul(m[4]));
+            if (!m[1].matched) return file::rotation_at_time_point(hour, minute, second);
+
+            std::string day = m[1];
+            if (std::isdigit(static_cast<unsigned char>(day[0])))
+                return file::rotation_at_time_point(boost::gregorian::greg_day(static_cast<unsigned short>(std::stoul(day))),
+                                                    hour, minute, second);
+
+            static const char* const weekdays[] = { "sun", "mon", "tue", "wed", "thu", "fri", "sat" };
+            std::transform(day.begin(), day.end(), day.begin(), [](unsigned char c) { return std::tolower(c); });
+            for (int i = 0; i < 7; ++i)
+                if (day.compare(0, 3, weekdays[i]) == 0)
+                    return file::rotation_at_time_point(static_cast<boost::date_time::weekdays>(i), hour, minute, second);
+            throw std::invalid_argument("invalid RotationTimePoint " + str);
+        }
+
+    public:
+        boost::shared_ptr<boost::log::sinks::sink> create_sink(const settings_section& settings) override
+        {
+            namespace file = boost::log::sinks::file;
+            auto name = settings["FileName"].get();
+            if (!name) throw std::invalid_argument("TextFile sink requires FileName");
+
+            auto backend = boost::make_shared<boost::log::sinks::text_file_backend>();
+            backend->set_file_name_pattern(boost::filesystem::path(*name));
+            if (auto size = settings["RotationSize"].get<std::uintmax_t>())
+                backend->set_rotation_size(*size);
+            if (auto interval = settings["RotationInterval"].get<unsigned int>())
+                backend->set_time_based_rotation(file::rotation_at_time_interval(boost::posix_time::seconds(*interval)));
+            else if (auto point = settings["RotationTimePoint"].get())
+                backend->set_time_based_rotation(parse_time_point(*point));
+            if (auto final_rotation = settings["EnableFinalRotation"].get<bool>())
+                backend->enable_final_rotation(*final_rotation);
+            if (auto mode = settings["AutoNewline"].get())
+                backend->set_auto_newline_mode(auto_newline_mode_from_string(*mode));
+            backend->auto_flush(settings["AutoFlush"].or_default(false));
+            if (settings["Append"].or_default(false))
+                backend->set_open_mode(std::ios_base::out | std::ios_base::app);
+
+            if (auto target = settings["Target"].get())
+            {
+                backend->set_file_collector(file::make_collector(
+                        boost::log::keywords::target = boost::filesystem::path(*target),
+                        boost::log::keywords::max_size = settings["MaxSize"].or_default(std::numeric_limits<std::uintmax_t>::max()),
+                        boost::log::keywords::min_free_space = settings["MinFreeSpace"].or_default(std::uintmax_t(0)),
+                        boost::log::keywords::max_files = settings["MaxFiles"].or_default(std::numeric_limits<std::uintmax_t>::max())));
+                if (auto scan = settings["ScanForFiles"].get())
+                {
+                    if (*scan == "All") backend->scan_for_files(file::scan_all);
+                    else if (*scan == "Matching") backend->scan_for_files(file::scan_matching);
+                    else throw std::invalid_argument("invalid ScanForFiles " + *scan);
+                }
+            }
+            return make_sink(settings, backend);
+        }
+    };
+
+    // [Sinks.NAME]
+    // Destination = BatchedFile
+    // FileName = app.log      # required
+    // Append = true           # append to an existing file instead of truncating it
+    // BatchBytes = 65536      # commit the batch once it holds that many bytes
+    // BatchRecords = 1024     # commit the batch once it holds that many records
+    // MaxLatency = 100        # milliseconds a record may stay in the batch, 0 for no limit
+    // FlushSeverity = ERROR   # records at or above commit the batch immediately
+    // IndexRecords = 0        # write the sidecar index FILE.idx with an entry per that many records, 0 for no index
+    // IndexBytes = 0          # or per that many bytes, queried by ing_logquery
+    class batched_file_sink_factory final : public boost::log::sink_factory<char>
+    {
+    public:
+        boost::shared_ptr<boost::log::sinks::sink> create_sink(const settings_section& settings) override
+        {
+            auto file = settings["FileName"].get();
+            if (!file) throw std::invalid_argument("BatchedFile sink requires FileName");
+
+            sinks::batched_file_backend::policy limits;
+            limits.bytes = settings["BatchBytes"].or_default(limits.bytes);
+            limits.records = settings["BatchRecords"].or_default(limits.records);
+            limits.latency = std::chrono::milliseconds(settings["MaxLatency"].or_default(limits.latency.count()));
+            if (auto severity = settings["FlushSeverity"].get())
+                limits.severity = boost::lexical_cast<severity_level>(*severity);
+            limits.index_records = settings["IndexRecords"].or_default(limits.index_records);
+            limits.index_bytes = settings["IndexBytes"].or_default(limits.index_bytes);
+
+            auto backend = boost::make_shared<sinks::batched_file_backend>(
+                    *file, settings["Append"].or_default(true), limits);
+            sinks::batched_file_registry::get().add(backend);
+            return make_sink(settings, backend);
+        }
+    };
+
+#ifndef _WIN32
+    // [Sinks.NAME]
+    // Destination = BinaryFile
+    // FileName = app.binlog   # required, decoded by ing_logcat
+    // Append = true           # append to an existing binary log instead of truncating it
+    // Extent = 16777216       # bytes pre-allocated and mapped whenever the file is full
+    class binary_file_sink_factory final : public boost::log::sink_factory<char>
+    {
+    public:
+        boost::shared_ptr<boost::log::sinks::sink> create_sink(const settings_section& settings) override
+        {
+            auto file = settings["FileName"].get();
+            if (!file) throw std::invalid_argument("BinaryFile sink requires FileName");
+
+            auto backend = boost::make_shared<sinks::binary_file_backend>(
+                    *file, settings["Append"].or_default(true), settings["Extent"].or_default(std::size_t(16) << 20));
+            return make_sink(settings, backend);
+        }
+    };
+#endif
+
+    /**
+     * @brief Build a sink of the destinations that init_logging builds before swapping the sinks, null for the
+     * other destinations, e.g. Syslog or those registered by the application, which Boost.Log builds.
+     */
+    boost::shared_ptr<boost::log::sinks::sink> build_sink(const std::string& destination,
+                                                          const boost::log::settings_section& settings)
+    {
+        static const auto& factories = *new std::map<std::string, boost::shared_ptr<boost::log::sink_factory<char>>>{
+            { "Console", boost::make_shared<console_sink_factory>() },
+            { "TextFile", boost::make_shared<text_file_sink_factory>() },
+            { "BatchedFile", boost::make_shared<batched_file_sink_factory>() },
+#ifndef _WIN32
+            { "BinaryFile", boost::make_shared<binary_file_sink_factory>() },
+#endif
+        };
+        auto iter = factories.find(destination);
+        return iter != factories.end() ? iter->second->create_sink(settings) : nullptr;
+    }
+
 #undef ARG
 }
 
 
+namespace ing::logging
+{
+    /**
+     * @brief Thread reloading a settings file once it changes. The directory of the file is watched with
+     * inotify where available, so that editors replacing the file are noticed, its time is polled otherwise.
+     */
+    class settings_watcher
+    {
+        std::mutex guard;
+        std::string file;
+        std::thread thread;
+        std::atomic<std::size_t> generation{0};
+
+        bool current(std::size_t gen) const noexcept
+        {
+            return generation.load(std::memory_order_acquire) == gen;
+        }
+
+        static void reload(const std::string& path)
+        {
+            // Settings failing to load leave the current configuration in place.
+            try
+            {
+                init_logging(path);
+            }
+            catch (const std::exception& e)
+            {
+                ING_GLOG(error) << "reloading " << path << " failed: " << e.what();
+            }
+        }
+
+        // The inotify descriptor already watches the directory of the file, -1 to poll the time of the file.
+        void run(std::string path, int fd, std::size_t gen)
+        {
+            set_thread_name("ing-log-watch");
+            namespace fs = std::filesystem;
+
+#ifdef __linux__
+            if (fd >= 0)
+            {
+                auto name = fs::path(path).filename().string();
+                while (current(gen))
+                {
+                    pollfd p{ fd, POLLIN, 0 };
+                    if (::poll(&p, 1, 200) <= 0) continue;
+
+                    bool changed = false;
+                    alignas(inotify_event) char buf[4096];
+                    for (ssize_t n; (n = ::read(fd, buf, sizeof(buf))) > 0;)
+                    {
+                        for (char* q = buf; q < buf + n;)
+                        {
+                            auto* e = reinterpret_cast<inotify_event*>(q);
+                            if (e->len && name == e->name) changed = true;
+                            q += sizeof(inotify_event) + e->len;
+                        }
+                    }
+                    if (changed && current(gen)) reload(path);
+                }
+                ::close(fd);
+                return;
+            }
+#endif
+
+            std::error_code ec;
+            auto last = fs::last_write_time(path, ec);
+            while (current(gen))
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                auto time = fs::last_write_time(path, ec);
+                if (!ec && time != last && current(gen))
+                {
+                    last = time;
+                    reload(path);
+                }
+            }
+        }
+
+        // Set up on the calling thread, so that changes made once watch returns are noticed.
+        static int open_watch(const std::string& path) noexcept
+        {
+#ifdef __linux__
+            if (int fd = ::inotify_init1(IN_CLOEXEC | IN_NONBLOCK); fd >= 0)
+            {
+                auto dir = std::filesystem::path(path).parent_path();
+                if (::inotify_add_watch(fd, dir.empty() ? "." : dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) >= 0)
+                    return fd;
+                ::close(fd);
+            }
+#endif
+            return -1;
+        }
+
+    public:
+        static settings_watcher& get()
+        {
+            static settings_watcher& watcher = *new settings_watcher;
+            return watcher;
+        }
+
+        /**
+         * @brief Watch the file, or stop watching if empty.
+         */
+        void watch(const std::string& path)
+        {
+            std::thread previous;
+            {
+                std::lock_guard _(guard);
+                if (path == file) return;
+                file = path;
+                auto gen = generation.fetch_add(1, std::memory_order_acq_rel) + 1;
+                previous = std::move(thread);
+                if (!path.empty())
+                    thread = std::thread(&settings_watcher::run, this, path, open_watch(path), gen);
+            }
+            // The watcher itself stops when a reload turns watching off.
+            if (previous.joinable())
+            {
+                if (previous.get_id() == std::this_thread::get_id()) previous.detach();
+                else previous.join();
+            }
+        }
+    };
+}
+
 namespace ing
 {
     BOOST_LOG_GLOBAL_LOGGER_CTOR_ARGS(global_logger, logger_mt, ("global"))
@@ -405,11 +4613,21 @@ namespace ing
     {
         auto setts = static_cast<const boost::log::settings*>(settings);
         init_logging(setts ? *setts : boost::log::settings{});
+        logging::settings_watcher::get().watch({});
     }
 
     void init_logging_from_stream(std::istream& in)
     {
         init_logging(boost::log::parse_settings(in));
+        logging::settings_watcher::get().watch({});
+    }
+
+    void flush_logging()
+    {
+        if (logging::async::global.enabled())
+            logging::async::global.flush();
+        else
+            boost::log::core::get()->flush();
     }
 
     void init_logging(const std::string& file)
@@ -421,7 +4639,11 @@ namespace ing
         else
         {
             std::ifstream in(file);
-            init_logging_from_stream(in);
+            auto settings = boost::log::parse_settings(in);
+            init_logging(settings);
+            // [Core]
+            // Watch = false  # reload the settings file once it changes
+            logging::settings_watcher::get().watch(settings["Core"]["Watch"].or_default(false) ? file : std::string());
         }
     }
 }
@@ -429,29 +4651,42 @@ namespace ing
 void ing::init_logging(const boost::log::settings& settings)
 {
     //boost::log::add_common_attributes();
+    // The new configuration is built aside while records keep flowing into the current sinks, then swapped in.
+    static std::mutex& serial = *new std::mutex;
+    std::lock_guard serialize(serial);
     auto core = boost::log::core::get();
-    // Reset core so that can be initialized multiple times.
-    core->set_logging_enabled(false);
-    core->remove_all_sinks();
-    core->reset_filter();
-    core->set_logging_enabled(true);
-
-    core->add_global_attribute(logging::expressions::timestamp_type::get_name(), logging::attributes::local_clock());
-    core->add_global_attribute(logging::expressions::thread_id_type::get_name(), logging::attributes::current_thread_id());
-    core->add_global_attribute(logging::expressions::process_id_type::get_name(), logging::attributes::current_process_id());
-    core->add_global_attribute(logging::expressions::thread_name_type::get_name(), logging::attributes::current_thread_name());
-    core->add_global_attribute(logging::expressions::process_name_type::get_name(), logging::attributes::current_process_name());
-    core->add_global_attribute(logging::expressions::scope_type::get_name(), logging::attributes::named_scope());
+
+    // Attributes referenced by the configured sinks are evaluated with each record. The others are lazy,
+    // i.e. evaluated only if a sink added later asks for them. Thread and process attributes are lazy anyway.
+    const auto referenced = logging::setup::referenced_attributes(settings);
+    auto eager = [&referenced](const auto& keyword) { return referenced.count(keyword.get_name().string()) != 0; };
+    auto attrs = core->get_global_attributes();
+    auto replace = [&attrs](const boost::log::attribute_name& name, const boost::log::attribute& attr)
+    {
+        attrs.erase(name);
+        attrs.insert(name, attr);
+    };
+    replace(logging::expressions::timestamp_type::get_name(), eager(logging::expressions::timestamp)
+            ? boost::log::attribute(logging::attributes::cached_local_clock())
+            : boost::log::attribute(logging::attributes::lazy_local_clock(&logging::attributes::cached_local_clock::now)));
+    replace(logging::expressions::thread_id_type::get_name(), logging::attributes::current_thread_id());
+    replace(logging::expressions::process_id_type::get_name(), logging::attributes::current_process_id());
+    replace(logging::expressions::thread_name_type::get_name(), logging::attributes::current_thread_name(
+            +[]() noexcept { return ing::get_thread_name(); }));
+    replace(logging::expressions::process_name_type::get_name(), logging::attributes::current_process_name());
+    replace(logging::expressions::scope_type::get_name(), eager(logging::expressions::scope)
+            ? boost::log::attribute(logging::attributes::named_scope())
+            : boost::log::attribute(logging::attributes::lazy_named_scope(
+                    +[] { return logging::attributes::named_scope::get_scopes(); })));
 
     // https://www.boost.org/doc/libs/develop/libs/log/doc/html/log/detailed/expressions.html#log.detailed.expressions.predicates.channel_severity_filter
-    logging::thresholds.clear();
+    auto thresholds = std::make_shared<logging::threshold_matcher>();
     if (auto severities = settings["Thresholds"].get_section())
     {
         for (const auto& entry : severities.property_tree())
         {
-            auto& pair = logging::thresholds.emplace_back();
-            pair.first = boost::lexical_cast<logging::expressions::severity_type::value_type>(entry.first);
-            pair.second.assign(entry.second.get_value<std::string>());
+            thresholds->add(boost::lexical_cast<logging::expressions::severity_type::value_type>(entry.first),
+                            entry.second.get_value<std::string>());
         }
     }
 
@@ -491,9 +4726,8 @@ void ing::init_logging(const boost::log::settings& settings)
 
     // https://www.boost.org/doc/libs/develop/libs/log/doc/html/log/detailed/expressions.html#log.detailed.expressions.formatters
     // stream-style syntax usually results in a faster formatter than the one constructed with the Boost.Format-style.
-    auto fmt = boost::log::expressions::stream
-            << logging::expressions::sgr(logging::expressions::severity, sgr_formatter_factory->table)
-            << boost::log::expressions::format_date_time(logging::expressions::timestamp, timestamp_formatter_factory->format) << ' '
+    boost::log::formatter plain = boost::log::expressions::stream
+            << logging::expressions::format_timestamp(logging::expressions::timestamp, timestamp_formatter_factory->format) << ' '
             << '[' << logging::expressions::severity << ']' << ' '
             << boost::log::expressions::if_(
                    logging::expressions::severity == logging::expressions::severity_type::value_type::info ||
@@ -517,24 +4751,177 @@ void ing::init_logging(const boost::log::settings& settings)
                            boost::log::keywords::iteration = logging::setup::scope_iteration_direction_from_string(
                                    scope_formatter_factory->iteration))
                ]
+            ;
+    boost::log::formatter fmt = boost::log::expressions::stream
+            << logging::expressions::sgr(logging::expressions::severity, sgr_formatter_factory->table)
+            << boost::log::expressions::wrap_formatter(plain)
             << logging::expressions::reset_sgr
             ;
 
-    boost::log::register_formatter_factory("Default", boost::make_shared<logging::setup::default_formatter_factory>(fmt));
+    boost::log::register_formatter_factory("Default", boost::make_shared<logging::setup::default_formatter_factory>(fmt, plain));
     boost::log::register_formatter_factory(logging::expressions::timestamp_type::get_name(), timestamp_formatter_factory);
     boost::log::register_formatter_factory(logging::expressions::location_type::get_name(), location_formatter_factory);
     boost::log::register_formatter_factory(logging::expressions::scope_type::get_name(), scope_formatter_factory);
     boost::log::register_formatter_factory("SGR", sgr_formatter_factory);
     logging::setup::register_simple_formatter_factory<logging::expressions::severity_type>();
+    logging::setup::register_simple_formatter_factory<logging::expressions::thread_name_type>();
+    logging::setup::register_simple_formatter_factory<logging::expressions::channel_type>();
+    boost::log::register_filter_factory(logging::expressions::channel_type::get_name(),
+                                        boost::make_shared<logging::setup::channel_filter_factory>());
+    boost::log::register_sink_factory("BatchedFile", boost::make_shared<logging::setup::batched_file_sink_factory>());
+#ifndef _WIN32
+    boost::log::register_sink_factory("BinaryFile", boost::make_shared<logging::setup::binary_file_sink_factory>());
+#endif
+
+    // [Sinks.NAME]
+    // SGR = false  # whether %Default% and %SGR% emit SGR sequences, by default only for consoles attached to a terminal
+    const bool terminal = logging::setup::is_terminal(stderr);
+    boost::log::settings sinks_settings = settings;
+    if (auto sinks = sinks_settings["Sinks"].get_section())
+    {
+        for (auto& sink : sinks.property_tree())
+        {
+            auto& tree = sink.second;
+            bool sgr = tree.get("SGR", terminal && tree.get("Destination", std::string()) == "Console");
+            tree.erase("SGR");
+            if (auto format = tree.get_optional<std::string>("Format"); format && !sgr)
+                tree.put("Format", logging::setup::disable_sgr(*format));
+        }
+    }
+
+    // Sinks of destinations that Boost.Log or the application implement can only be added to the core by
+    // Boost.Log, they are built during the swap.
+    std::vector<logging::sinks::route> built[2];
+    boost::log::settings foreign;
+    bool storing_arguments = false;
+    if (auto sinks = sinks_settings["Sinks"].get_section())
+    {
+        for (auto& sink : sinks.property_tree())
+        {
+            auto destination = sink.second.get_optional<std::string>("Destination");
+            if (!destination) throw std::invalid_argument("sink " + sink.first + " requires Destination");
+            storing_arguments |= *destination == "BinaryFile";
+            boost::log::settings section(sink.second);
+            if (!section["ThreadName"]) section["ThreadName"] = "ing-sink-" + sink.first;
+            if (auto s = logging::setup::build_sink(*destination, section))
+            {
+                auto meter = logging::metrics::sink_registry::get().meter(sink.first);
+                if (auto* queue = dynamic_cast<logging::sinks::overflow_queue*>(s.get()))
+                    queue->attach(std::exchange(meter, nullptr));
+                bool routed = logging::setup::routable(section);
+                built[s->is_cross_thread()].push_back({ std::move(s), std::move(meter), routed });
+            }
+            else if (auto others = foreign.property_tree().get_child_optional("Sinks"))
+                others->push_back(sink);
+            else
+                foreign.property_tree().put_child("Sinks", {}).push_back(sink);
+        }
+    }
+    else
+    {
+        auto backend = boost::make_shared<boost::log::sinks::text_ostream_backend>();
+        backend->add_stream(boost::shared_ptr<std::ostream>(&std::clog, boost::null_deleter()));
+        backend->set_auto_newline_mode(boost::log::sinks::insert_if_missing);
+        backend->auto_flush(true);
+        auto sink = boost::make_shared<boost::log::sinks::synchronous_sink<boost::log::sinks::text_ostream_backend>>(backend);
+        sink->set_formatter(terminal ? fmt : plain);
+        built[false].push_back({ std::move(sink), logging::metrics::sink_registry::get().meter("Default"), true });
+    }
+
+    // [Core]
+    // Filter = ...             # evaluated before the filters of the sinks
+    // DisableLogging = false
+    boost::log::filter filter;
+    if (auto f = settings["Core"]["Filter"].get())
+        filter = boost::log::parse_filter(*f);
+
+    // Swap. Records opened while the core is without the routers are opened again by the loggers.
+    // Sinks of foreign destinations failing to build leave the current configuration in place.
+    static auto& foreign_current = *new boost::log::settings;
+    std::shared_ptr<const logging::sinks::route_table> retired[2];
+    std::exception_ptr error;
+    {
+        std::lock_guard _(logging::reload_guard());
+        logging::reload_generation.fetch_add(1);
+        for (bool cross_thread : { false, true })
+            retired[cross_thread] = logging::sinks::router::get(cross_thread)->swap(
+                    std::make_shared<const logging::sinks::route_table>(std::move(built[cross_thread])));
+        // Sinks added to the core directly, including by a previous configuration, are removed.
+        core->remove_all_sinks();
+        core->add_sink(logging::sinks::router::get(false));
+        core->add_sink(logging::sinks::router::get(true));
+        try
+        {
+            if (foreign.has_section("Sinks"))
+                boost::log::init_from_settings(foreign);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        if (error)
+        {
+            // The new sinks are retired instead, the foreign ones of the current configuration are built again.
+            for (bool cross_thread : { false, true })
+                retired[cross_thread] = logging::sinks::router::get(cross_thread)->swap(std::move(retired[cross_thread]));
+            core->remove_all_sinks();
+            core->add_sink(logging::sinks::router::get(false));
+            core->add_sink(logging::sinks::router::get(true));
+            try
+            {
+                if (foreign_current.has_section("Sinks"))
+                    boost::log::init_from_settings(foreign_current);
+            }
+            catch (...)
+            {
+            }
+        }
+        else
+        {
+            foreign_current = std::move(foreign);
+            core->set_global_attributes(attrs);
+            logging::channel_table::get().update(std::move(thresholds));
+            core->set_filter(filter);
+            core->set_logging_enabled(!settings["Core"]["DisableLogging"].or_default(false));
+            logging::storing_arguments.store(storing_arguments, std::memory_order_relaxed);
+        }
+        logging::reload_generation.fetch_add(1);
+        logging::reload_done().notify_all();
+    }
 
-    boost::log::init_from_settings(settings);
-    if (settings.has_section("Sinks")) return;
+    // Retired sinks are flushed and released once the records they are consuming are done.
+    for (auto& sinks : retired)
+    {
+        while (sinks.use_count() > 1)
+            std::this_thread::yield();
+        for (const auto& r : sinks->sinks)
+            r.sink->flush();
+        sinks.reset();
+    }
+    if (error) std::rethrow_exception(error);
 
-    boost::log::add_console_log(std::clog,
-        boost::log::keywords::auto_newline_mode = boost::log::sinks::insert_if_missing,
-        boost::log::keywords::auto_flush = true,
-        // boost::log::keywords::filter = ,
-        boost::log::keywords::format = fmt
-    );
+    // [Core]
+    // Asynchronous = false        # records are pushed to the sinks by a dedicated backend thread
+    // RingCapacity = 1024         # capacity of the per-thread record ring
+    // DeferredFormatting = false  # fmt arguments are copied and formatted by the backend thread
+    // FlightRecorder = 0          # records below the thresholds kept per thread, dumped into the sinks on
+    //                             # fatal, 0 to disable
+    // FlightRecorderFile = path   # file the records are written to on SIGSEGV and SIGABRT, stderr by default
+    // Metrics = false             # count records per channel and time the sinks, see ing::logging::metrics::report
+    logging::flight_recorder::get().configure(settings["Core"]["FlightRecorder"].or_default(std::size_t(0)),
+                                              settings["Core"]["FlightRecorderFile"].or_default(std::string()));
+    logging::metrics::collecting.store(settings["Core"]["Metrics"].or_default(false), std::memory_order_relaxed);
+    // The backend thread is restarted only if its settings change, queued records reach the new sinks anyway.
+    if (settings["Core"]["Asynchronous"].or_default(false))
+    {
+        auto capacity = settings["Core"]["RingCapacity"].or_default(std::size_t(1024));
+        auto defer = settings["Core"]["DeferredFormatting"].or_default(false);
+        if (!logging::async::global.enabled() || !logging::async::global.configured(capacity, defer))
+            logging::async::global.start(capacity, defer);
+    }
+    else
+    {
+        logging::async::global.stop();
+    }
 }
 
@@ -2,16 +2,66 @@
 
 #include <boost/mpl/list.hpp>
 
+#include <boost/log/attributes/constant.hpp>
 #include <boost/log/attributes/named_scope.hpp>
+#include <boost/log/attributes/scoped_attribute.hpp>
 
+#include <boost/log/expressions.hpp>
+#include <boost/log/expressions/formatters/date_time.hpp>
+#include <boost/log/support/date_time.hpp>
+
+#include <boost/log/sinks/basic_sink_backend.hpp>
+#include <boost/log/sinks/sync_frontend.hpp>
+#include <boost/log/sinks/text_ostream_backend.hpp>
 #include <boost/log/utility/setup/console.hpp>
+#include <boost/log/utility/setup/from_settings.hpp>
 
 #include <ing/logging.hpp>
+#include <ing/threading.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <new>
+#include <set>
 #include <sstream>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 namespace utf = boost::unit_test;
 
+static std::atomic<long> allocations{0};
+
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
 struct DefaultSetting
 {
     DefaultSetting()
@@ -67,7 +117,7 @@ struct ThresholdPerLogger
         std::istringstream in(
 R"INI(
 [Thresholds]
-WARN = global  # global will be TRACE as it has already been initialized.
+WARN = global  # global will be WARN although it has already been initialized.
 WARN = "lo.*"  # local will be WARN.
 ERROR = local
 
@@ -84,11 +134,34 @@ FATAL = "31;44" # fg: Red, bg: Blue
     }
 };
 
+struct AsynchronousSetting
+{
+    AsynchronousSetting()
+    {
+        BOOST_TEST_MESSAGE("asynchronous setting");
+
+        std::istringstream in(
+R"INI(
+[Core]
+Asynchronous = true
+RingCapacity = 64
+)INI");
+
+        ing::init_logging_from_stream(in);
+    }
+
+    ~AsynchronousSetting()
+    {
+        ing::init_logging();
+    }
+};
+
 using Settings = boost::mpl::list<
     DefaultSetting,
     DefaultFormatterTemplate,
     CustomFormatterTemplate,
-    ThresholdPerLogger
+    ThresholdPerLogger,
+    AsynchronousSetting
 >;
 
 BOOST_FIXTURE_TEST_CASE_TEMPLATE(logging, Setting, Settings, Setting)
@@ -153,3 +226,1316 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE(logging, Setting, Settings, Setting)
 #endif
 }
 
+
+BOOST_FIXTURE_TEST_CASE(asynchronous, AsynchronousSetting)
+{
+    std::ostringstream strm;
+    boost::log::core::get()->remove_all_sinks();
+    auto sink = boost::log::add_console_log(strm, boost::log::keywords::format = "%Message%");
+
+    constexpr int threads = 4;
+    constexpr int records = 1000;
+    std::vector<std::thread> producers;
+    for (int i = 0; i < threads; ++i)
+    {
+        producers.emplace_back([i] {
+            ing::logger_mt logger("async");
+            for (int j = 0; j < records; ++j)
+                logger.info() << i << ':' << j;
+        });
+    }
+    for (auto& t : producers) t.join();
+
+    ing::flush_logging();
+
+    std::istringstream lines(strm.str());
+    std::vector<int> next(threads);
+    int count = 0;
+    for (std::string line; std::getline(lines, line); ++count)
+    {
+        auto i = std::stoi(line);
+        auto j = std::stoi(line.substr(line.find(':') + 1));
+        BOOST_TEST_REQUIRE(j == next[i]++);
+    }
+    BOOST_TEST(count == threads * records);
+
+    boost::log::core::get()->remove_sink(sink);
+}
+
+BOOST_FIXTURE_TEST_CASE(asynchronous_reentrant, AsynchronousSetting)
+{
+    // Logs from the backend thread more records than its ring holds.
+    struct relay : boost::log::sinks::basic_sink_backend<boost::log::sinks::synchronized_feeding>
+    {
+        std::vector<std::string> messages;
+
+        void consume(const boost::log::record_view& rec)
+        {
+            auto message = *rec[boost::log::expressions::smessage];
+            messages.push_back(message);
+            if (message == "outer")
+                for (int i = 0; i < 200; ++i)
+                    ing::info() << "inner " << i;
+        }
+    };
+
+    boost::log::core::get()->remove_all_sinks();
+    auto backend = boost::make_shared<relay>();
+    auto sink = boost::make_shared<boost::log::sinks::synchronous_sink<relay>>(backend);
+    boost::log::core::get()->add_sink(sink);
+
+    ing::info() << "outer";
+    ing::flush_logging();
+
+    BOOST_TEST_REQUIRE(backend->messages.size() == 201u);
+    BOOST_TEST(backend->messages.front() == "outer");
+    BOOST_TEST(backend->messages.back() == "inner 199");
+
+    boost::log::core::get()->remove_sink(sink);
+}
+
+BOOST_AUTO_TEST_CASE(thresholds)
+{
+    using ing::logging::severity_level;
+    using ing::logging::minimum_severity_level;
+
+    std::istringstream in(
+R"INI(
+[Thresholds]
+ERROR = "db\\.primary"
+WARN  = "db\\..*"
+INFO  = "db.*"
+DEBUG = "(http|grpc)\\.server"
+FATAL = "http.server"
+)INI");
+
+    ing::init_logging_from_stream(in);
+
+    BOOST_TEST(minimum_severity_level("db.primary") == severity_level::error);
+    BOOST_TEST(minimum_severity_level("db.replica") == severity_level::warn);
+    BOOST_TEST(minimum_severity_level("dbx") == severity_level::info);
+    BOOST_TEST(minimum_severity_level("db") == severity_level::info);
+    BOOST_TEST(minimum_severity_level("http.server") == severity_level::debug);
+    BOOST_TEST(minimum_severity_level("http-server") == severity_level::fatal);
+    BOOST_TEST(minimum_severity_level("grpc.server") == severity_level::debug);
+    BOOST_TEST(minimum_severity_level("other") == severity_level::trace);
+    BOOST_TEST(minimum_severity_level("other") == severity_level::trace);
+
+    ing::logger primary("db.primary");
+    ing::logger_mt replica("db.replica");
+    ing::logger_mt copy(replica);
+    ing::logger pinned("db.primary", severity_level::debug);
+    BOOST_TEST(!primary.is_warn_enabled());
+    BOOST_TEST(!replica.is_info_enabled());
+    BOOST_TEST(pinned.is_debug_enabled());
+
+    ing::init_logging();
+
+    BOOST_TEST(minimum_severity_level("db.primary") == severity_level::trace);
+    BOOST_TEST(minimum_severity_level("http.server") == severity_level::trace);
+    BOOST_TEST(primary.is_trace_enabled());
+    BOOST_TEST(replica.is_trace_enabled());
+    BOOST_TEST(copy.is_trace_enabled());
+    BOOST_TEST(!pinned.is_trace_enabled());
+    BOOST_TEST(ing::is_trace_enabled());
+
+    std::istringstream reload(
+R"INI(
+[Thresholds]
+DEBUG = "db\\..*"
+ERROR = global
+)INI");
+
+    ing::init_logging_from_stream(reload);
+
+    BOOST_TEST(!primary.is_trace_enabled());
+    BOOST_TEST(primary.is_debug_enabled());
+    BOOST_TEST(copy.is_debug_enabled());
+    BOOST_TEST(!ing::is_warn_enabled());
+    BOOST_TEST(ing::is_error_enabled());
+
+    // Loggers moved to another channel follow its threshold, pinned ones keep their level.
+    ing::logger moved("db.primary");
+    moved.channel("global");
+    pinned.channel("global");
+    BOOST_TEST(!moved.is_warn_enabled());
+    BOOST_TEST(moved.is_error_enabled());
+    BOOST_TEST(pinned.is_debug_enabled());
+    std::istringstream relaxed("[Thresholds]\nWARN = global\n");
+    ing::init_logging_from_stream(relaxed);
+    BOOST_TEST(moved.is_warn_enabled());
+    BOOST_TEST(!moved.is_info_enabled());
+    BOOST_TEST(pinned.is_debug_enabled());
+    std::istringstream strict(R"INI(
+[Thresholds]
+DEBUG = "db\\..*"
+ERROR = global
+)INI");
+    ing::init_logging_from_stream(strict);
+
+    // Operands of suppressed records are not evaluated unless kept by the flight recorder.
+    int evaluated = 0;
+    auto count = [&evaluated] { return ++evaluated; };
+    ING_GLOG(debug) << count() << count();
+    ING_LOG(primary, trace) << count();
+    ING_LOG_SEV(copy, severity_level::trace) << count();
+    BOOST_TEST(evaluated == 0);
+
+    ing::init_logging();
+}
+
+BOOST_AUTO_TEST_CASE(callsites)
+{
+    using ing::logging::callsite_id;
+    using ing::logging::register_callsite;
+    using ing::logging::callsite_location;
+
+    std::vector<callsite_id> ids;
+    for (int i = 0; i < 2; ++i)
+        ids.push_back(ING_CALLSITE());
+    BOOST_TEST((ids[0] == ids[1]));
+
+    auto loc = ing::source_location::current();
+    auto id = register_callsite(loc);
+    BOOST_TEST((id == register_callsite(loc)));
+    BOOST_TEST((id != ids[0]));
+    BOOST_TEST(callsite_location(id).line() == loc.line());
+    BOOST_TEST(callsite_location(id).file_name() == loc.file_name());
+    BOOST_TEST(callsite_location(ids[0]).line() == loc.line() - 3);
+    BOOST_TEST(callsite_location(callsite_id{}).line() == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(callsite_policies)
+{
+    std::ostringstream strm;
+    boost::log::core::get()->remove_all_sinks();
+    auto sink = boost::log::add_console_log(strm, boost::log::keywords::format = "%Message%");
+
+    auto lines = [&strm] {
+        std::vector<std::string> v;
+        std::istringstream in(strm.str());
+        for (std::string line; std::getline(in, line);) v.push_back(line);
+        strm.str({});
+        return v;
+    };
+
+    for (int i = 0; i < 10; ++i)
+        ING_GLOG_EVERY_N(warn, 4) << i;
+    BOOST_TEST(lines() == (std::vector<std::string>{ "0", "[3 suppressed] 4", "[3 suppressed] 8" }),
+               boost::test_tools::per_element());
+
+    auto rate = [] { ING_GLOG_RATE(error, 5/s) << "burst"; };
+    for (int i = 0; i < 100; ++i) rate();
+    auto burst = lines();
+    BOOST_TEST(burst.size() >= 5u);
+    BOOST_TEST(burst.size() < 10u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    rate();
+    auto after = lines();
+    BOOST_TEST_REQUIRE(after.size() == 1u);
+    BOOST_TEST(after[0].find(" suppressed] burst") != std::string::npos);
+
+    ing::logger logger("policies");
+    for (int i = 0; i < 100; ++i)
+    {
+        ING_LLOG_SAMPLE(info, 0) << i;
+        ING_LLOG_SAMPLE(info, 1.0) << i;
+    }
+    BOOST_TEST(lines().size() == 100u);
+
+    int evaluated = 0;
+    for (int i = 0; i < 10000; ++i)
+        ING_LLOG_SAMPLE(info, 0.5) << ++evaluated;
+    BOOST_TEST(evaluated > 4000);
+    BOOST_TEST(evaluated < 6000);
+    BOOST_TEST(lines().size() == std::size_t(evaluated));
+
+    boost::log::core::get()->remove_sink(sink);
+}
+
+BOOST_AUTO_TEST_CASE(timestamp_formatter)
+{
+    namespace pt = boost::posix_time;
+    namespace expr = boost::log::expressions;
+
+    ing::init_logging();
+    boost::log::core::get()->remove_all_sinks();
+
+    const char* formats[] = { "%H:%M:%S.%f", "%Y-%m-%d %H:%M:%S.%f", "%f|%S|%f", "%H:%M:%S", "%T.%f" };
+    for (const std::string format : formats)
+    {
+        std::ostringstream cached, reference;
+        auto s1 = boost::log::add_console_log(cached, boost::log::keywords::format = "%TimeStamp(format=\"" + format + "\")%");
+        auto s2 = boost::log::add_console_log(reference, boost::log::keywords::format =
+                expr::stream << expr::format_date_time<pt::ptime>("TimeStamp", format));
+
+        const pt::ptime base(boost::gregorian::date(2024, 2, 29), pt::time_duration(23, 59, 58));
+        const pt::time_duration offsets[] = {
+            pt::microseconds(0), pt::microseconds(1), pt::microseconds(999999), pt::microseconds(1000000),
+            pt::microseconds(1000001), pt::microseconds(2123456), pt::microseconds(1500000), pt::hours(24),
+        };
+        for (auto offset : offsets)
+        {
+            BOOST_LOG_SCOPED_THREAD_ATTR("TimeStamp", boost::log::attributes::constant<pt::ptime>(base + offset));
+            ING_GLOG(info);
+        }
+        {
+            BOOST_LOG_SCOPED_THREAD_ATTR("TimeStamp", boost::log::attributes::constant<pt::ptime>(pt::not_a_date_time));
+            ING_GLOG(info);
+        }
+        ING_GLOG(info);
+
+        boost::log::core::get()->remove_sink(s1);
+        boost::log::core::get()->remove_sink(s2);
+        BOOST_TEST(!cached.str().empty());
+        BOOST_TEST(cached.str() == reference.str());
+    }
+
+    // More formatters at once than the caches of a thread hold, interleaved per record.
+    std::vector<std::ostringstream> cached(std::size(formats)), reference(std::size(formats));
+    std::vector<boost::shared_ptr<boost::log::sinks::sink>> sinks;
+    for (std::size_t i = 0; i < std::size(formats); ++i)
+    {
+        const std::string format = formats[i];
+        sinks.push_back(boost::log::add_console_log(cached[i], boost::log::keywords::format = "%TimeStamp(format=\"" + format + "\")%"));
+        sinks.push_back(boost::log::add_console_log(reference[i], boost::log::keywords::format =
+                expr::stream << expr::format_date_time<pt::ptime>("TimeStamp", format)));
+    }
+    const pt::ptime base(boost::gregorian::date(2024, 2, 29), pt::time_duration(23, 59, 58));
+    for (int us : { 2500000, 1000001, 2999999, 1, 3000000 })
+    {
+        BOOST_LOG_SCOPED_THREAD_ATTR("TimeStamp", boost::log::attributes::constant<pt::ptime>(base + pt::microseconds(us)));
+        ING_GLOG(info);
+    }
+    for (const auto& sink : sinks)
+        boost::log::core::get()->remove_sink(sink);
+    for (std::size_t i = 0; i < std::size(formats); ++i)
+        BOOST_TEST(cached[i].str() == reference[i].str());
+
+    ing::init_logging();
+}
+
+BOOST_AUTO_TEST_CASE(location_formatter)
+{
+    ing::init_logging();
+    boost::log::core::get()->remove_all_sinks();
+
+    std::ostringstream strm;
+    auto sink = boost::log::add_console_log(strm, boost::log::keywords::format =
+            "%LineID(format=\"%l\")% %LineID(format=\"%F:%l\")%");
+
+    std::vector<unsigned> lines;
+    for (int i = 0; i < 2; ++i)
+    {
+        lines.push_back(__LINE__); ING_GLOG(info);
+        lines.push_back(__LINE__); ING_GLOG(warn);
+    }
+
+    std::ostringstream expected;
+    for (auto line : lines)
+        expected << line << " test_logging.cpp:" << line << '\n';
+    BOOST_TEST(strm.str() == expected.str());
+
+    boost::log::core::get()->remove_sink(sink);
+    ing::init_logging();
+}
+
+BOOST_AUTO_TEST_CASE(sink_sgr)
+{
+    auto capture = [](const char* ini) {
+        std::ostringstream strm;
+        auto* buf = std::clog.rdbuf(strm.rdbuf());
+        std::istringstream in(ini);
+        ing::init_logging_from_stream(in);
+        ING_GLOG(warn) << "\033[1;34mblue\033[0m \033m \033[x \033[";
+        ing::flush_logging();
+        ing::init_logging();
+        std::clog.rdbuf(buf);
+        return strm.str();
+    };
+
+    auto plain = capture(R"INI(
+[Sinks.Console]
+Destination = Console
+SGR = false
+Format = "%SGR%<%Message%>%SGR(mode=reset)%|%Default%"
+)INI");
+    BOOST_TEST(plain.find("<\033[1;34mblue") == 0u);
+    BOOST_TEST(plain.find("\033[33m") == std::string::npos);
+    BOOST_TEST(plain.find("\033[39;49m") == std::string::npos);
+
+    auto colour = capture(R"INI(
+[Sinks.Console]
+Destination = Console
+SGR = true
+Format = "%SGR%<%Message%>%SGR(mode=reset)%"
+)INI");
+    BOOST_TEST(colour == "\033[33m<\033[1;34mblue\033[0m \033m \033[x \033[>\033[39;49m\n");
+
+    auto stripped = capture(R"INI(
+[Sinks.Console]
+Destination = Console
+SGR = true
+Format = "%SGR%<%Message%>%SGR(mode=reset)%%SGR(mode=strip)%"
+)INI");
+    BOOST_TEST(stripped == "<blue \033m \033[x \033[>\n");
+}
+
+BOOST_AUTO_TEST_CASE(lazy_attributes)
+{
+    std::istringstream in(R"INI(
+[Sinks.Console]
+Destination = Console
+Format = "%Message%"
+)INI");
+    ing::init_logging_from_stream(in);
+    boost::log::core::get()->remove_all_sinks();
+
+    // TimeStamp and Scope are not referenced by the configured sinks, but a sink added later still sees them.
+    std::ostringstream strm;
+    auto sink = boost::log::add_console_log(strm, boost::log::keywords::format =
+            "%TimeStamp(format=\"%Y\")% %Scope(format=\"%n\",depth=1,auto_newline=0,incomplete_marker=\"\",threshold=TRACE)%");
+    {
+        BOOST_LOG_NAMED_SCOPE("lazy");
+        ING_GLOG(info);
+    }
+    auto year = boost::posix_time::second_clock::local_time().date().year();
+    BOOST_TEST(strm.str() == std::to_string(year) + " lazy\n");
+
+    boost::log::core::get()->remove_sink(sink);
+    ing::init_logging();
+}
+
+BOOST_AUTO_TEST_CASE(thread_name)
+{
+    auto saved = ing::get_thread_name();
+    ing::init_logging();
+    boost::log::core::get()->remove_all_sinks();
+
+    std::ostringstream strm;
+    auto sink = boost::log::add_console_log(strm, boost::log::keywords::format = "%ThreadName% %Message%");
+
+    ing::set_thread_name("first");
+    ING_GLOG(info) << 1;
+    ing::set_thread_name("second");
+    ING_GLOG(info) << 2;
+    std::thread([] {
+        ing::set_thread_name("worker");
+        ING_GLOG(info) << 3;
+    }).join();
+    BOOST_TEST(strm.str() == "first 1\nsecond 2\nworker 3\n");
+    boost::log::core::get()->remove_sink(sink);
+
+    // Detached by the asynchronous frontend before the thread is renamed again
+    std::istringstream in("[Core]\nAsynchronous = true\n[Sinks.Null]\nDestination = Console\nFilter = \"%Channel% = none\"\n");
+    ing::init_logging_from_stream(in);
+    strm.str({});
+    sink = boost::log::add_console_log(strm, boost::log::keywords::format = "%ThreadName% %Message%");
+    ing::set_thread_name("third");
+    ING_GLOG(info) << 4;
+    ing::set_thread_name("fourth");
+    ING_GLOG(info) << 5;
+    ing::flush_logging();
+    BOOST_TEST(strm.str() == "third 4\nfourth 5\n");
+
+    boost::log::core::get()->remove_sink(sink);
+    ing::set_thread_name(saved);
+    ing::init_logging();
+}
+
+BOOST_AUTO_TEST_CASE(channels)
+{
+    using ing::logging::channel_name;
+
+    std::string db = "db";
+    channel_name a(db), b("db"), c("dbx");
+    BOOST_TEST((a == b));
+    BOOST_TEST((a != c));
+    BOOST_TEST((a.handle() == b.handle()));
+    BOOST_TEST((a < c));
+    BOOST_TEST(a.view() == "db");
+    BOOST_TEST((channel_name() == channel_name("")));
+
+    ing::logger lg("db.primary");
+    BOOST_TEST((lg.channel() == channel_name("db.primary")));
+    BOOST_TEST(ing::logging::channel_threshold(lg.channel()).get() ==
+               ing::logging::channel_threshold("db.primary").get());
+
+    std::istringstream in(R"INI(
+[Sinks.Console]
+Destination = Console
+Filter = "(%Channel% begins_with \"db.\" and %Channel% != \"db.replica\") or %Channel% matches \"ht+p\""
+Format = "<%Channel%> %Message%"
+)INI");
+    std::ostringstream strm;
+    auto* buf = std::clog.rdbuf(strm.rdbuf());
+    ing::init_logging_from_stream(in);
+    for (const char* channel : { "db.primary", "db.replica", "db", "http", "htp", "https" })
+        ing::logger(channel).info() << 1;
+    ing::init_logging();
+    std::clog.rdbuf(buf);
+    BOOST_TEST(strm.str() == "<db.primary> 1\n<http> 1\n<htp> 1\n");
+}
+
+BOOST_AUTO_TEST_CASE(pooled_message)
+{
+    struct discard : std::streambuf
+    {
+        std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+        int_type overflow(int_type c) override { return c; }
+    } sink;
+    std::ostream out(&sink);
+
+    ing::init_logging();
+    boost::log::core::get()->remove_all_sinks();
+    boost::log::add_console_log(out, boost::log::keywords::format = "%Message%");
+
+    auto count = [](auto f)
+    {
+        for (int i = 0; i < 100; ++i) f(i);
+        long before = allocations.load();
+        for (int i = 0; i < 1000; ++i) f(i);
+        return allocations.load() - before;
+    };
+
+    // The record itself is still allocated by the core; streaming must add nothing on top.
+    long empty = count([](int) { ing::info(); });
+    long message = count([](int i)
+    {
+        ing::info() << "a message well beyond the small string buffer, number " << i << ' ' << 3.5;
+    });
+    BOOST_TEST(message == empty);
+
+    std::ostringstream strm;
+    boost::log::core::get()->remove_all_sinks();
+    boost::log::add_console_log(strm, boost::log::keywords::format = "%Message%");
+    ing::info() << "first";
+    ing::info() << "second";
+    BOOST_TEST(strm.str() == "first\nsecond\n");
+    ing::init_logging();
+}
+
+namespace
+{
+    struct point { int x, y; };
+
+    std::ostream& operator<<(std::ostream& os, const point& p)
+    {
+        return os << '(' << p.x << ", " << p.y << ')';
+    }
+}
+
+BOOST_AUTO_TEST_CASE(fast_insertion)
+{
+    std::ostringstream strm;
+    ing::init_logging();
+    boost::log::core::get()->remove_all_sinks();
+    boost::log::add_console_log(strm, boost::log::keywords::format = "%Message%");
+
+    auto values = [](auto&& os)
+    {
+        std::string s = "str";
+        const char* cs = "cstr";
+        char arr[8] = "arr";
+        os << 0 << ' ' << -1 << ' ' << std::numeric_limits<long long>::min() << ' '
+           << std::numeric_limits<unsigned long long>::max() << ' ' << short(-7) << ' '
+           << 3.5 << ' ' << 0.1 << ' ' << 1.0 / 3 << ' ' << 1e300 << ' ' << -0.0 << ' ' << 1.5f << ' '
+           << 123456789.0 << ' ' << 2.5L << ' ' << true << 'c' << static_cast<unsigned char>('u')
+           << s << std::string_view("view") << cs << "literal" << arr << point{ 1, -2 } << 42
+           << std::hex << 255 << std::dec << std::setw(5) << 7 << std::setw(4) << "w"
+           << std::setprecision(3) << 3.14159 << std::boolalpha << false << std::endl << 1;
+    };
+
+    std::ostringstream expected;
+    values(expected);
+    values(ing::info());
+    ING_GLOG(info) << "macro " << 1.25 << ' ' << point{ 3, 4 };
+    {
+        auto h = ing::info();
+        h << 1;
+        h.stream() << '-' << 2 << std::showpos;
+        h << 3 << std::noshowpos << 4;
+    }
+    BOOST_TEST(strm.str() == expected.str() + "\nmacro 1.25 (3, 4)\n1-2+34\n");
+    ing::init_logging();
+}
+
+BOOST_AUTO_TEST_CASE(batched_file_sink)
+{
+    auto path = std::filesystem::temp_directory_path() / "ing_test_batched_file_sink.log";
+    auto lines = [&path]
+    {
+        std::ifstream in(path);
+        std::string line;
+        std::vector<std::string> result;
+        while (std::getline(in, line)) result.push_back(line);
+        return result;
+    };
+
+    std::istringstream in(R"INI(
+[Sinks.Batched]
+Destination = BatchedFile
+FileName = ")INI" + path.string() + R"INI("
+Append = false
+BatchRecords = 4
+MaxLatency = 0
+Format = "%Message%"
+)INI");
+    ing::init_logging_from_stream(in);
+
+    for (int i = 0; i < 10; ++i)
+        ing::info() << i;
+    BOOST_TEST(lines().size() == 8u);
+    ing::error() << "error";
+    BOOST_TEST(lines().size() == 11u);
+    BOOST_TEST(lines().back() == "error");
+    ing::info() << "flushed";
+    ing::flush_logging();
+    BOOST_TEST(lines().size() == 12u);
+
+    std::ostringstream report;
+    ing::logging::sinks::report(report);
+    BOOST_TEST(report.str() == "file\trecords\tbytes\tsyscalls\trecords/syscall\tfailed batches\tlost records\n" +
+                               path.string() + "\t12\t34\t4\t3.00\t0\t0\n");
+
+#ifdef __linux__
+    // Records of batches that fail to be written are not counted as written.
+    std::istringstream full(R"INI(
+[Sinks.Full]
+Destination = BatchedFile
+FileName = "/dev/full"
+BatchRecords = 2
+MaxLatency = 0
+Format = "%Message%"
+)INI");
+    ing::init_logging_from_stream(full);
+    for (int i = 0; i < 5; ++i)
+        ing::info() << i;
+    ing::flush_logging();
+    report.str({});
+    ing::logging::sinks::report(report);
+    BOOST_TEST(report.str().find("/dev/full\t0\t0\t3\t0.00\t3\t5\n") != std::string::npos);
+#endif
+
+    std::istringstream latency(R"INI(
+[Sinks.Batched]
+Destination = BatchedFile
+FileName = ")INI" + path.string() + R"INI("
+Append = false
+MaxLatency = 200
+Format = "%Message%"
+)INI");
+    ing::init_logging_from_stream(latency);
+    ing::info() << "late";
+    BOOST_TEST(lines().empty());
+    for (int i = 0; i < 300 && lines().empty(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    BOOST_TEST(lines() == std::vector<std::string>{ "late" });
+
+    ing::init_logging();
+    std::filesystem::remove(path);
+}
+
+namespace
+{
+    // Holds the writes of the sink until opened, so that its queue overflows meanwhile.
+    struct gated_buf : std::stringbuf
+    {
+        std::mutex guard;
+        std::condition_variable cond;
+        bool entered = false;
+        bool opened = false;
+        std::string writer;  // name of the thread writing first
+
+        std::streamsize xsputn(const char* s, std::streamsize n) override
+        {
+            {
+                std::unique_lock lock(guard);
+                if (!entered) writer = ing::get_thread_name().view();
+                entered = true;
+                cond.notify_all();
+                cond.wait(lock, [this] { return opened; });
+            }
+            return std::stringbuf::xsputn(s, n);
+        }
+
+        void wait_entered()
+        {
+            std::unique_lock lock(guard);
+            cond.wait(lock, [this] { return entered; });
+        }
+
+        void open()
+        {
+            std::lock_guard _(guard);
+            opened = true;
+            cond.notify_all();
+        }
+    };
+
+    // A filtered sink accepts its own channel only, the channel of the drop summary included.
+    std::vector<std::string> overflow(const std::string& policy, int records, bool filtered = false)
+    {
+        gated_buf buf;
+        auto* clog = std::clog.rdbuf(&buf);
+        std::string channel = "overflow." + policy + (filtered ? ".filtered" : "");
+        std::istringstream in(R"INI(
+[Sinks.Console]
+Destination = Console
+Filter = ")INI" + (filtered ? "%Channel% = " + channel : "") + R"INI("
+Asynchronous = true
+QueueCapacity = 4
+Overflow = )INI" + policy + R"INI(
+OverflowSeverity = ERROR
+DropSummary = 0
+Format = "%Message%"
+)INI");
+        ing::init_logging_from_stream(in);
+
+        ing::logger lg(channel);
+        lg.info() << "first";
+        buf.wait_entered();
+        std::thread producer([&lg, records]
+        {
+            for (int i = 0; i < records; ++i)
+                (i % 2 ? lg.error() : lg.info()) << i;
+        });
+        if (policy == "DropBelow")
+        {
+            while (lg.channel().handle()->dropped_records == 0)
+                std::this_thread::yield();
+        }
+        else if (policy != "Block")
+        {
+            producer.join();
+        }
+        buf.open();
+        if (producer.joinable()) producer.join();
+        ing::init_logging();
+        std::clog.rdbuf(clog);
+
+        std::istringstream out(buf.str());
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(out, line);)
+            lines.push_back(line);
+        return lines;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(overflow_policies)
+{
+    auto dropped = [](const std::string& channel)
+    {
+        return ing::logging::channel_name(channel).handle()->dropped_records.load();
+    };
+    const std::string summary = "sink queue overflowed, dropped 6 records, 6 bytes (overflow.";
+
+    auto newest = overflow("DropNewest", 10);
+    BOOST_TEST(newest == (std::vector<std::string>{ "first", "0", "1", "2", "3",
+                                                    summary + "DropNewest: 6 records, 6 bytes)" }));
+    BOOST_TEST(dropped("overflow.DropNewest") == 6u);
+
+    auto filtered = overflow("DropNewest", 10, true);
+    BOOST_TEST(filtered == (std::vector<std::string>{ "first", "0", "1", "2", "3",
+                                                      summary + "DropNewest.filtered: 6 records, 6 bytes)" }));
+
+    auto oldest = overflow("DropOldest", 10);
+    BOOST_TEST(oldest == (std::vector<std::string>{ "first", "6", "7", "8", "9",
+                                                    summary + "DropOldest: 6 records, 6 bytes)" }));
+    BOOST_TEST(dropped("overflow.DropOldest") == 6u);
+
+    // Errors block until the queue has room, the info records beyond the capacity are dropped.
+    auto below = overflow("DropBelow", 20);
+    BOOST_TEST(dropped("overflow.DropBelow") > 0u);
+    auto summaries = std::count_if(below.begin(), below.end(), [](const std::string& line)
+    {
+        return line.rfind("sink queue overflowed", 0) == 0;
+    });
+    BOOST_TEST(summaries > 0);
+    BOOST_TEST(below.size() - summaries == 1 + 20 - dropped("overflow.DropBelow"));
+    for (int i = 1; i < 20; i += 2)
+        BOOST_TEST(std::count(below.begin(), below.end(), std::to_string(i)) == 1);
+
+    auto blocked = overflow("Block", 10);
+    BOOST_TEST(blocked.size() == 11u);
+    BOOST_TEST(dropped("overflow.Block") == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(metrics)
+{
+    std::ostringstream strm;
+    auto* buf = std::clog.rdbuf(strm.rdbuf());
+    std::istringstream in(R"INI(
+[Core]
+Metrics = true
+[Thresholds]
+INFO = metrics.test
+[Sinks.MetricsSync]
+Destination = Console
+Filter = "%Channel% = metrics.test"
+Format = "%Message%"
+[Sinks.MetricsAsync]
+Destination = Console
+Asynchronous = true
+Filter = "%Channel% = metrics.test"
+Format = "%Message%"
+)INI");
+    ing::init_logging_from_stream(in);
+
+    ing::logger lg("metrics.test");
+    std::thread([&lg]
+    {
+        for (int i = 0; i < 3; ++i) lg.info() << "abc";
+    }).join();
+    lg.error() << "de";
+    lg.debug() << "filtered";
+    lg.debug() << "filtered";
+    ing::flush_logging();
+
+    std::ostringstream report;
+    ing::logging::metrics::report(report);
+    ing::init_logging();
+    std::clog.rdbuf(buf);
+
+    std::istringstream lines(report.str());
+    std::map<std::string, std::vector<std::string>> rows;
+    for (std::string line; std::getline(lines, line);)
+    {
+        std::vector<std::string> fields;
+        std::istringstream row(line);
+        for (std::string field; std::getline(row, field, '\t');)
+            fields.push_back(field);
+        rows[fields[0] + (fields[0] == "metrics.test" ? "/" + fields[1] : "")] = fields;
+    }
+    BOOST_TEST(rows["channel"] == (std::vector<std::string>{ "channel", "severity", "emitted", "filtered", "bytes" }));
+    BOOST_TEST(rows["metrics.test/DEBUG"] == (std::vector<std::string>{ "metrics.test", "DEBUG", "0", "2", "0" }));
+    BOOST_TEST(rows["metrics.test/INFO"] == (std::vector<std::string>{ "metrics.test", "INFO", "3", "0", "9" }));
+    BOOST_TEST(rows["metrics.test/ERROR"] == (std::vector<std::string>{ "metrics.test", "ERROR", "1", "0", "2" }));
+    BOOST_TEST(rows["sink"] == (std::vector<std::string>{ "sink", "records", "mean", "p50", "p90", "p99", "max", "queued" }));
+    BOOST_TEST(rows["MetricsSync"].size() == 8u);
+    BOOST_TEST(rows["MetricsSync"][1] == "4");
+    BOOST_TEST(rows["MetricsAsync"].size() == 8u);
+    BOOST_TEST(rows["MetricsAsync"][1] == "4");
+    BOOST_TEST(rows["MetricsAsync"][7] == "0");
+}
+
+BOOST_AUTO_TEST_CASE(sink_workers)
+{
+    auto path = std::filesystem::temp_directory_path() / "ing_test_sink_workers.log";
+    auto count = [&path]
+    {
+        std::ifstream in(path);
+        std::size_t n = 0;
+        for (std::string line; std::getline(in, line);) ++n;
+        return n;
+    };
+
+    gated_buf buf;
+    auto* clog = std::clog.rdbuf(&buf);
+    std::istringstream in(R"INI(
+[Sinks.Slow]
+Destination = Console
+Asynchronous = true
+Format = "%Message%"
+[Sinks.Fast]
+Destination = BatchedFile
+FileName = ")INI" + path.string() + R"INI("
+Append = false
+BatchRecords = 1
+Asynchronous = true
+ThreadName = fast-sink
+Format = "%Message%"
+)INI");
+    ing::init_logging_from_stream(in);
+
+    // The console sink is stuck writing the first record, the file sink keeps up meanwhile.
+    ing::info() << 0;
+    buf.wait_entered();
+    for (int i = 1; i < 100; ++i)
+        ing::info() << i;
+    for (int i = 0; i < 300 && count() < 100; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    BOOST_TEST(count() == 100u);
+    BOOST_TEST(buf.str().empty());
+
+    buf.open();
+    ing::init_logging();
+    std::clog.rdbuf(clog);
+    BOOST_TEST(buf.writer == "ing-sink-Slow");
+    auto written = buf.str();
+    BOOST_TEST(std::count(written.begin(), written.end(), '\n') == 100);
+    std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(channel_routing)
+{
+    std::ostringstream strm;
+    auto* buf = std::clog.rdbuf(strm.rdbuf());
+    auto configure = [](const std::string& a)
+    {
+        std::istringstream in(R"INI(
+[Sinks.A]
+Destination = Console
+Filter = "%Channel% = )INI" + a + R"INI("
+Format = "A %Message%"
+[Sinks.B]
+Destination = Console
+Filter = "%Channel% begins_with \"route.b\""
+Format = "B %Message%"
+[Sinks.C]
+Destination = Console
+Filter = "%Tag% = yes"
+Format = "C %Message%"
+)INI");
+        ing::init_logging_from_stream(in);
+    };
+    configure("route.a");
+
+    ing::logger a("route.a"), b("route.b.x"), c("route.c");
+    a.info() << 1;
+    b.info() << 2;
+    c.info() << 3;
+    {
+        BOOST_LOG_SCOPED_THREAD_TAG("Tag", std::string("yes"));
+        c.info() << 4;
+        a.info() << 5;
+    }
+    a.info() << 6;
+
+    // The table is rebuilt with the sinks.
+    configure("route.c");
+    a.info() << 7;
+    c.info() << 8;
+    ing::init_logging();
+    std::clog.rdbuf(buf);
+
+    BOOST_TEST(strm.str() == "A 1\nB 2\nC 4\nA 5\nC 5\nA 6\nA 8\n");
+}
+
+BOOST_AUTO_TEST_CASE(gap_free_reload)
+{
+    auto path = std::filesystem::temp_directory_path() / "ing_test_gap_free_reload.log";
+    std::filesystem::remove(path);
+    // Toggling the backend thread, records pushed while it stops are delivered too.
+    auto settings = [&path](int records, bool asynchronous)
+    {
+        return R"INI(
+[Core]
+Asynchronous = )INI" + std::string(asynchronous ? "true" : "false") + R"INI(
+[Sinks.Batched]
+Destination = BatchedFile
+FileName = ")INI" + path.string() + R"INI("
+BatchRecords = )INI" + std::to_string(records) + R"INI(
+Format = "%Message%"
+)INI";
+    };
+    std::istringstream in(settings(16, false));
+    ing::init_logging_from_stream(in);
+
+    constexpr int threads = 4;
+    constexpr int records = 20000;
+    std::atomic<int> running{threads};
+    std::vector<std::thread> producers;
+    for (int t = 0; t < threads; ++t)
+    {
+        producers.emplace_back([&running, t]
+        {
+            ing::logger lg("reload");
+            for (int i = 0; i < records; ++i)
+                lg.info() << t << ' ' << i;
+            --running;
+        });
+    }
+    for (int i = 0; running > 0; ++i)
+    {
+        std::istringstream next(settings(8 << (i % 4), i % 2 == 0));
+        ing::init_logging_from_stream(next);
+    }
+    for (auto& t : producers) t.join();
+    ing::init_logging();
+
+    std::ifstream log(path);
+    std::set<std::string> lines;
+    std::size_t count = 0;
+    for (std::string line; std::getline(log, line); ++count)
+        lines.insert(line);
+    BOOST_TEST(count == std::size_t(threads * records));
+    BOOST_TEST(lines.size() == std::size_t(threads * records));
+    std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(failed_reload)
+{
+    // Destinations implemented by the application, one writing to a stream and one failing to build.
+    static std::ostringstream foreign;
+    struct stream_factory : boost::log::sink_factory<char>
+    {
+        boost::shared_ptr<boost::log::sinks::sink> create_sink(const boost::log::settings_section&) override
+        {
+            auto backend = boost::make_shared<boost::log::sinks::text_ostream_backend>();
+            backend->add_stream(boost::shared_ptr<std::ostream>(&foreign, boost::null_deleter()));
+            auto sink = boost::make_shared<boost::log::sinks::synchronous_sink<boost::log::sinks::text_ostream_backend>>(backend);
+            sink->set_formatter(boost::log::expressions::stream << boost::log::expressions::smessage << '\n');
+            return sink;
+        }
+    };
+    struct failing_factory : boost::log::sink_factory<char>
+    {
+        boost::shared_ptr<boost::log::sinks::sink> create_sink(const boost::log::settings_section&) override
+        {
+            throw std::runtime_error("unavailable");
+        }
+    };
+    boost::log::register_sink_factory("TestStream", boost::make_shared<stream_factory>());
+    boost::log::register_sink_factory("TestFailing", boost::make_shared<failing_factory>());
+
+    std::ostringstream strm;
+    auto* buf = std::clog.rdbuf(strm.rdbuf());
+    std::istringstream in(R"INI(
+[Sinks.Console]
+Destination = Console
+Format = "old %Message%"
+[Sinks.Stream]
+Destination = TestStream
+)INI");
+    ing::init_logging_from_stream(in);
+
+    std::istringstream next(R"INI(
+[Thresholds]
+ERROR = global
+[Sinks.Console]
+Destination = Console
+Format = "new %Message%"
+[Sinks.Failing]
+Destination = TestFailing
+)INI");
+    BOOST_CHECK_THROW(ing::init_logging_from_stream(next), std::exception);
+
+    ing::info() << "kept";
+    ing::flush_logging();
+    BOOST_TEST(strm.str() == "old kept\n");
+    BOOST_TEST(foreign.str() == "kept\n");
+
+    ing::init_logging();
+    std::clog.rdbuf(buf);
+}
+
+BOOST_AUTO_TEST_CASE(watch_settings)
+{
+    auto path = std::filesystem::temp_directory_path() / "ing_test_watch_settings.ini";
+    auto write = [&path](const std::string& format)
+    {
+        auto tmp = path.string() + ".tmp";
+        std::ofstream(tmp) << "[Core]\nWatch = true\n[Sinks.Console]\nDestination = Console\nFormat = \"" << format << "\"\n";
+        std::filesystem::rename(tmp, path);
+    };
+
+    std::ostringstream strm;
+    auto* buf = std::clog.rdbuf(strm.rdbuf());
+    write("A %Message%");
+    ing::init_logging(path.string());
+    ing::info() << "first";
+
+    write("B %Message%");
+    for (int i = 0; i < 300 && strm.str().find("B second") == std::string::npos; ++i)
+    {
+        ing::info() << "second";
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ing::init_logging();
+    std::clog.rdbuf(buf);
+
+    BOOST_TEST(strm.str().rfind("A first\n", 0) == 0);
+    BOOST_TEST(strm.str().find("B second\n") != std::string::npos);
+    std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(batched_file_index)
+{
+    auto path = std::filesystem::temp_directory_path() / "ing_test_batched_file_index.log";
+    std::istringstream in(R"INI(
+[Sinks.Batched]
+Destination = BatchedFile
+FileName = ")INI" + path.string() + R"INI("
+Append = false
+IndexRecords = 10
+Format = "%Severity% <%Channel%> %Message%"
+)INI");
+    ing::init_logging_from_stream(in);
+
+    ing::logger a("idx.a");
+    ing::logger b("idx.b");
+    for (int i = 0; i < 55; ++i)
+        a.info() << i;
+    b.error() << "failed";
+    for (int i = 0; i < 44; ++i)
+        a.info() << i;
+    ing::init_logging();
+
+    auto read = [&path]
+    {
+        std::ifstream log(path, std::ios_base::binary);
+        return std::string((std::istreambuf_iterator<char>(log)), std::istreambuf_iterator<char>());
+    };
+    auto query = [&](const ing::logging::sinks::index_query& q)
+    {
+        auto content = read();
+        std::vector<std::string> blocks;
+        ing::logging::sinks::query_index(path.string(), q, [&](std::uint64_t offset, std::uint64_t size)
+        {
+            blocks.push_back(content.substr(offset, size));
+        });
+        return blocks;
+    };
+    auto lines = [](const std::string& block) { return std::count(block.begin(), block.end(), '\n'); };
+
+    ing::logging::sinks::index_query all;
+    BOOST_TEST(query(all) == std::vector<std::string>{ read() });
+
+    ing::logging::sinks::index_query errors;
+    errors.severity = ing::logging::severity_level::error;
+    auto blocks = query(errors);
+    BOOST_TEST_REQUIRE(blocks.size() == 1u);
+    BOOST_TEST(lines(blocks[0]) == 10);
+    BOOST_TEST(blocks[0].find("ERROR <idx.b> failed\n") != std::string::npos);
+
+    ing::logging::sinks::index_query channel;
+    channel.channels = { "idx.b" };
+    BOOST_TEST(query(channel) == blocks);
+
+    ing::logging::sinks::index_query future;
+    future.from = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch() + std::chrono::hours(48)).count();
+    BOOST_TEST(query(future).empty());
+
+    // Records appended by a session without index are not ruled out.
+    std::istringstream unindexed(R"INI(
+[Sinks.Batched]
+Destination = BatchedFile
+FileName = ")INI" + path.string() + R"INI("
+Format = "%Message%"
+)INI");
+    ing::init_logging_from_stream(unindexed);
+    a.info() << "tail";
+    ing::init_logging();
+    blocks = query(errors);
+    BOOST_TEST_REQUIRE(blocks.size() == 2u);
+    BOOST_TEST(blocks[1] == "tail\n");
+
+    // A trailing partial entry is ignored, then cut off by the next session appending to the index.
+    {
+        std::ofstream idx(path.string() + ".idx", std::ios_base::binary | std::ios_base::app);
+        idx.write("partial", 7);
+    }
+    BOOST_TEST(query(errors) == blocks);
+    std::istringstream reopened(R"INI(
+[Sinks.Batched]
+Destination = BatchedFile
+FileName = ")INI" + path.string() + R"INI("
+IndexRecords = 1
+Format = "%Severity% <%Channel%> %Message%"
+)INI");
+    ing::init_logging_from_stream(reopened);
+    a.info() << "info";
+    b.error() << "again";
+    ing::init_logging();
+    blocks = query(errors);
+    BOOST_TEST_REQUIRE(blocks.size() == 3u);
+    BOOST_TEST(blocks[1] == "tail\n");
+    BOOST_TEST(blocks[2] == "ERROR <idx.b> again\n");
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(path.string() + ".idx");
+}
+
+#ifndef _WIN32
+BOOST_AUTO_TEST_CASE(binary_file_sink)
+{
+    auto path = std::filesystem::temp_directory_path() / "ing_test_binary_file_sink.binlog";
+    std::istringstream in(R"INI(
+[Sinks.Binary]
+Destination = BinaryFile
+FileName = ")INI" + path.string() + R"INI("
+Append = false
+Extent = 4096
+)INI");
+    ing::init_logging_from_stream(in);
+
+    ing::logger db("bin.db");
+    ing::logger net("bin.net");
+    for (int i = 0; i < 100; ++i)
+        db.info() << "query " << i;
+    ING_LOG(net, warn) << "timeout";
+    db.error() << std::string(5000, 'x');
+    ing::init_logging();
+    // Extents not used are released once the sink is gone.
+    BOOST_TEST(std::filesystem::file_size(path) < 3 * 4096u);
+
+    std::vector<ing::logging::sinks::binary_record> records;
+    std::vector<std::string> messages;
+    std::vector<std::string> files;
+    ing::logging::sinks::read_binary_file(path.string(), [&](const ing::logging::sinks::binary_record& rec)
+    {
+        records.push_back(rec);
+        messages.emplace_back(rec.message);
+        files.emplace_back(rec.location ? rec.location->file_name() : "");
+    });
+    BOOST_TEST_REQUIRE(records.size() == 102u);
+    BOOST_TEST(messages[0] == "query 0");
+    BOOST_TEST(messages[99] == "query 99");
+    BOOST_TEST(messages[101] == std::string(5000, 'x'));
+    BOOST_TEST((records[100].severity == ing::logging::severity_level::warn));
+    BOOST_TEST((records[101].severity == ing::logging::severity_level::error));
+    BOOST_TEST(records[100].time.has_value());
+    BOOST_TEST(*records[100].time <= *records[101].time);
+    BOOST_TEST(files[100] == __FILE__);
+
+    std::istringstream console(R"INI(
+[Sinks.Console]
+Destination = Console
+Format = "%Severity% <%Channel%> %Message%"
+)INI");
+    std::ostringstream strm;
+    auto* buf = std::clog.rdbuf(strm.rdbuf());
+    ing::init_logging_from_stream(console);
+    auto n = ing::logging::sinks::replay_binary_file(path.string(), [](const ing::logging::sinks::binary_record& rec)
+    {
+        return rec.channel == std::string_view("bin.net") || rec.message == "query 7";
+    });
+    ing::flush_logging();
+    std::clog.rdbuf(buf);
+    BOOST_TEST(n == 2u);
+    BOOST_TEST(strm.str() == "INFO <bin.db> query 7\nWARN <bin.net> timeout\n");
+
+    ing::init_logging();
+    std::filesystem::remove(path);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(flight_recorder)
+{
+    std::istringstream in(R"INI(
+[Core]
+FlightRecorder = 4
+[Thresholds]
+WARN = "fr\\..*"
+[Sinks.Console]
+Destination = Console
+Format = "%Severity% <%Channel%> %Message%"
+)INI");
+    std::ostringstream strm;
+    auto* buf = std::clog.rdbuf(strm.rdbuf());
+    ing::init_logging_from_stream(in);
+
+    ing::logger lg("fr.db");
+    ING_LOG(lg, trace) << "too old";
+    ING_LOG(lg, debug) << "query " << 42 << ' ' << 2.5 << ' ' << true << ' ' << std::string("users");
+    lg.info() << "unsigned " << 7u << ' ' << point{ 1, 2 };
+    lg.warn() << "emitted";
+    lg.debug() << "long " << std::string(200, 'x');
+    lg.info() << std::hex << -3;
+    BOOST_TEST(strm.str() == "WARN <fr.db> emitted\n");
+
+    lg.fatal() << "crash";
+    BOOST_TEST(strm.str() == "WARN <fr.db> emitted\n"
+                             "DEBUG <fr.db> [flight] query 42 2.5 1 users\n"
+                             "INFO <fr.db> [flight] unsigned 7 {?}\n"
+                             "DEBUG <fr.db> [flight] long " + std::string(87, 'x') + "...\n"
+                             "INFO <fr.db> [flight] -3\n"
+                             "FATAL <fr.db> crash\n");
+
+    strm.str(std::string());
+    lg.fatal() << "again";
+    BOOST_TEST(strm.str() == "FATAL <fr.db> again\n");
+
+    ing::init_logging();
+    std::clog.rdbuf(buf);
+}
+
+#ifndef _WIN32
+BOOST_AUTO_TEST_CASE(flight_recorder_signal)
+{
+    auto path = std::filesystem::temp_directory_path() / "ing_test_flight_recorder.log";
+    std::filesystem::remove(path);
+    pid_t pid = fork();
+    BOOST_TEST_REQUIRE(pid >= 0);
+    if (pid == 0)
+    {
+        // The default action, not the handler of the test framework, must follow the dump.
+        std::signal(SIGABRT, SIG_DFL);
+        std::istringstream in(R"INI(
+[Core]
+FlightRecorder = 16
+FlightRecorderFile = ")INI" + path.string() + R"INI("
+[Thresholds]
+ERROR = global
+[Sinks.Console]
+Destination = Console
+)INI");
+        ing::init_logging_from_stream(in);
+        ing::set_thread_name("crasher");
+        ing::debug() << "before abort " << 1 << ' ' << 2.5 << ' ' << std::string("x");
+        std::abort();
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    BOOST_TEST(WIFSIGNALED(status));
+    BOOST_TEST(WTERMSIG(status) == SIGABRT);
+
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    // 2024-01-31 12:00:00.000000Z DEBUG <global> [crasher] test_logging.cpp:42 [flight] ...
+    BOOST_TEST_REQUIRE(line.size() > 28);
+    BOOST_TEST(line[10] == ' ');
+    BOOST_TEST(line[26] == 'Z');
+    auto rest = line.substr(28);
+    BOOST_TEST(rest.rfind("DEBUG <global> [crasher] test_logging.cpp:", 0) == 0);
+    BOOST_TEST(rest.substr(rest.find(" [flight]")) == " [flight] before abort 1 2.5 x");
+    BOOST_TEST(!std::getline(in, line));
+    in.close();
+    std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(flush_at_exit)
+{
+    auto batched = std::filesystem::temp_directory_path() / "ing_test_exit_batched.log";
+    auto text = std::filesystem::temp_directory_path() / "ing_test_exit_text.log";
+    pid_t pid = fork();
+    BOOST_TEST_REQUIRE(pid >= 0);
+    if (pid == 0)
+    {
+        std::istringstream in(R"INI(
+[Sinks.Batched]
+Destination = BatchedFile
+FileName = ")INI" + batched.string() + R"INI("
+Append = false
+BatchRecords = 1024
+MaxLatency = 0
+Format = "%Message%"
+[Sinks.Text]
+Destination = TextFile
+FileName = ")INI" + text.string() + R"INI("
+AutoFlush = false
+Format = "%Message%"
+)INI");
+        ing::init_logging_from_stream(in);
+        ing::info() << "last words";
+        std::exit(0);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    BOOST_TEST(WIFEXITED(status));
+    for (const auto& path : { batched, text })
+    {
+        std::ifstream in(path);
+        std::string line;
+        BOOST_TEST(!!std::getline(in, line));
+        BOOST_TEST(line == "last words");
+        in.close();
+        std::filesystem::remove(path);
+    }
+}
+#endif
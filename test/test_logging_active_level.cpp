@@ -0,0 +1,50 @@
+#include <boost/test/unit_test.hpp>
+
+#include <ing/logging.hpp>
+
+static_assert(ING_LOG_ACTIVE_LEVEL == 2);
+static_assert(!ing::logging::active(ing::logging::severity_level::trace));
+static_assert(!ing::logging::active(ing::logging::severity_level::debug));
+static_assert(ing::logging::active(ing::logging::severity_level::info));
+
+
+BOOST_AUTO_TEST_CASE(logging_active_level)
+{
+    ing::init_logging();
+
+    int evaluated = 0;
+    auto eval = [&evaluated] { return ++evaluated; };
+
+    ing::logger logger("local");
+
+    ING_LLOG(trace) << "A trace severity message " << eval();
+    ING_LLOG(debug) << "A debug severity message " << eval();
+    ING_GLOG(trace) << "A trace severity message " << eval();
+    ING_GLOG(debug) << "A debug severity message " << eval();
+    ING_GLOG_SEV(ing::logging::severity_level::debug) << "A debug severity message " << eval();
+    BOOST_TEST(evaluated == 0);
+
+    ING_LLOG(info) << "An info severity message " << eval();
+    ING_GLOG(info) << "An info severity message " << eval();
+    BOOST_TEST(evaluated == 2);
+
+    BOOST_TEST(!logger.is_trace_enabled());
+    BOOST_TEST(!logger.is_debug_enabled());
+    BOOST_TEST(logger.is_info_enabled());
+    BOOST_TEST(!ing::is_trace_enabled());
+    BOOST_TEST(!ing::is_debug_enabled());
+    BOOST_TEST(ing::is_info_enabled());
+
+    BOOST_TEST(!logger.trace());
+    BOOST_TEST(!logger.debug());
+    BOOST_TEST(!!logger.info());
+    BOOST_TEST(!ing::trace());
+    BOOST_TEST(!ing::debug());
+    BOOST_TEST(!ing::log(ing::logging::severity_level::debug));
+    BOOST_TEST(!!ing::info());
+
+#ifdef ING_HAS_FMT
+    BOOST_TEST(!ing::debug("A debug severity message at line {} ", __LINE__));
+    BOOST_TEST(!!ing::info("An info severity message at line {} ", __LINE__));
+#endif
+}
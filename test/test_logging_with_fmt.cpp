@@ -2,8 +2,24 @@
 
 #include <boost/log/attributes/named_scope.hpp>
 
+#include <boost/log/utility/setup/console.hpp>
+
 #include <ing/logging.hpp>
 
+#if defined(ING_WITH_FMT)
+#include <fmt/chrono.h>
+#endif
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <sstream>
+
+#if defined(FMT_HAS_CONSTEVAL) && defined(__cpp_consteval)
+static_assert(!std::is_same_v<ing::fmt::format_string<int>, ing::fmt::string_view>,
+              "format strings are checked at compile time");
+#endif
 
 BOOST_AUTO_TEST_CASE(logging_with_fmt)
 {
@@ -45,3 +61,103 @@ BOOST_AUTO_TEST_CASE(logging_with_fmt)
     if (auto h = ing::error("An error severity message at line {} ", __LINE__)) h << ing::fmt::format("{}", __func__);
     if (auto h = ing::fatal("A fatal severity message at line {} ", __LINE__)) h << ing::fmt::format("{}", __func__);
 }
+
+BOOST_AUTO_TEST_CASE(deferred_formatting)
+{
+    std::istringstream in(
+R"INI(
+[Core]
+Asynchronous = true
+DeferredFormatting = true
+)INI");
+
+    ing::init_logging_from_stream(in);
+
+    std::ostringstream strm;
+    boost::log::core::get()->remove_all_sinks();
+    boost::log::add_console_log(strm, boost::log::keywords::format = "%Message%");
+
+    ing::logger logger("deferred");
+    std::string str = "string";
+    logger.info("{} {:.2f} {}", 1, 2.5, 'c') << " suffix";
+    logger.info("{} {}", std::chrono::seconds(3), true);
+    logger.info("{} {}", str, 4);
+    str = "changed";
+    ing::info("{:x}", 255);
+    ing::flush_logging();
+
+    BOOST_TEST(strm.str() == "1 2.50 c suffix\n3s true\nstring 4\nff\n");
+
+    ing::init_logging();
+}
+
+BOOST_AUTO_TEST_CASE(direct_formatting)
+{
+    ing::init_logging();
+
+    std::ostringstream strm;
+    boost::log::core::get()->remove_all_sinks();
+    boost::log::add_console_log(strm, boost::log::keywords::format = "%Message%");
+
+    std::string text(300, 'x');
+    ing::logger logger("direct");
+    logger.info("{} {:>5} {:.3f}|", 1, "ab", 3.14159) << 2 << ' ' << 0.5;
+    ing::info("{}{}", text, '!');
+    if (auto h = ing::warn("{:#x} ", 255))
+    {
+        h.stream() << std::hex << 255;
+        h << ' ' << 7;
+    }
+    ing::info(ing::fmt::string_view("{}-{}"), ing::fmt::make_format_args(3, 4));
+
+    BOOST_TEST(strm.str() == "1    ab 3.142|2 0.5\n" + text + "!\n0xff ff 7\n3-4\n");
+    ing::init_logging();
+}
+
+#ifndef _WIN32
+BOOST_AUTO_TEST_CASE(binary_arguments)
+{
+    auto path = std::filesystem::temp_directory_path() / "ing_test_binary_arguments.binlog";
+    std::istringstream in(R"INI(
+[Sinks.Binary]
+Destination = BinaryFile
+FileName = ")INI" + path.string() + R"INI("
+Append = false
+)INI");
+    ing::init_logging_from_stream(in);
+
+    // Messages read back are those fmt formats, whether the arguments were stored or the text.
+    std::vector<std::string> expected;
+#define ING_TEST_LOG(...) (ing::info(__VA_ARGS__), expected.push_back(ing::fmt::format(__VA_ARGS__)))
+    ING_TEST_LOG("{} {:.2f} {}", 1, 2.5, 'c');
+    ING_TEST_LOG("{:>8.3f}|{:<5}|{:^7}|{:+d}|{:#x}|{:#o}|{:08.2f}|{:b}", 3.14159, 42, true, 7, 255, 8, -2.5, 5u);
+    ING_TEST_LOG("{1} {0} {0:e} {{}}", 0.1, -3LL);
+    ING_TEST_LOG("{} {} {} {} {:g} {:E} {:a} {:.3}", 1e15, 1e16, 1e-5, 1.0 / 3, 1e-7, 12345.678, 1.5, 2.0 / 3);
+    ING_TEST_LOG("{:*^9}|{:c}|{}|{:X}|{: }", 'x', 65, false, 48879u, 2);
+    ING_TEST_LOG("{} {}", std::numeric_limits<long long>::min(), std::numeric_limits<unsigned long long>::max());
+    ING_TEST_LOG("{} {}", std::chrono::seconds(3), 4);
+    ING_TEST_LOG("{:>{}}|{:#.0f}", 1, 5, 3.0);
+#undef ING_TEST_LOG
+    ing::info("{}", 1) << " suffix";
+    expected.push_back("1 suffix");
+    ing::init_logging();
+
+    std::vector<std::string> messages;
+    ing::logging::sinks::read_binary_file(path.string(), [&messages](const ing::logging::sinks::binary_record& rec)
+    {
+        messages.emplace_back(rec.message);
+    });
+    BOOST_TEST(messages == expected, boost::test_tools::per_element());
+
+#if defined(__cpp_consteval)
+    // Format strings are stored in place of the formatted messages.
+    std::ifstream file(path, std::ios_base::binary);
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    BOOST_TEST(content.find("{:>8.3f}|{:<5}") != std::string::npos);
+    BOOST_TEST(content.find("   3.142|42") == std::string::npos);
+    BOOST_TEST(content.find("3s 4") != std::string::npos);
+    file.close();
+#endif
+    std::filesystem::remove(path);
+}
+#endif
@@ -0,0 +1,125 @@
+#include <ing/logging.hpp>
+
+#include <boost/log/core/core.hpp>
+#include <boost/log/utility/setup/console.hpp>
+#include <boost/log/utility/setup/formatter_parser.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <optional>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const char usage[] =
+        "Usage: ing_logcat [options] file...\n"
+        "Decode files written by BinaryFile sinks.\n"
+        "\n"
+        "  --from TIME       skip records logged before TIME, \"YYYY-MM-DD HH:MM:SS[.ffffff]\" in local time\n"
+        "  --to TIME         skip records logged after TIME\n"
+        "  --channel REGEX   keep only channels matching REGEX, may be repeated\n"
+        "  --severity LEVEL  skip records below LEVEL\n"
+        "  --format FORMAT   formatter template, %Default(sgr=0)% by default\n"
+        "  --config FILE     logging settings, e.g. for the [Attributes] used by %Default%\n";
+
+    std::int64_t parse_time(const std::string& str)
+    {
+        using namespace boost::posix_time;
+        auto t = time_from_string(str);
+        if (t.is_special()) throw std::invalid_argument("invalid time " + str);
+        return (t - ptime(boost::gregorian::date(1970, 1, 1))).total_microseconds();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::optional<std::int64_t> from, to;
+    std::vector<std::regex> channels;
+    std::optional<ing::logging::severity_level> severity;
+    std::string format = "%Default(sgr=0)%";
+    std::string config;
+    std::vector<std::string> files;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string
+            {
+                if (i + 1 >= argc) throw std::invalid_argument(arg + " requires a value");
+                return argv[++i];
+            };
+
+            if (arg == "--help" || arg == "-h")
+            {
+                std::cout << usage;
+                return 0;
+            }
+            else if (arg == "--from") from = parse_time(value());
+            else if (arg == "--to") to = parse_time(value());
+            else if (arg == "--channel") channels.emplace_back(value());
+            else if (arg == "--severity")
+            {
+                auto level = value();
+                std::transform(level.begin(), level.end(), level.begin(), [](unsigned char c) { return std::toupper(c); });
+                ing::logging::severity_level l;
+                if (!ing::logging::from_string(level, l)) throw std::invalid_argument("invalid severity " + level);
+                severity = l;
+            }
+            else if (arg == "--format") format = value();
+            else if (arg == "--config") config = value();
+            else if (arg.size() > 1 && arg[0] == '-') throw std::invalid_argument("unknown option " + arg);
+            else files.push_back(arg);
+        }
+        if (files.empty()) throw std::invalid_argument("no file");
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "ing_logcat: " << e.what() << '\n' << usage;
+        return 2;
+    }
+
+    try
+    {
+        // Register the formatters of the library, then render into stdout instead of the configured sinks.
+        ing::init_logging(config);
+        auto core = boost::log::core::get();
+        core->remove_all_sinks();
+        boost::log::add_console_log(std::cout,
+            boost::log::keywords::auto_newline_mode = boost::log::sinks::insert_if_missing,
+            boost::log::keywords::format = boost::log::parse_formatter(format));
+
+        auto filter = [&](const ing::logging::sinks::binary_record& rec)
+        {
+            if ((from || to) && !rec.time) return false;
+            if (from && *rec.time < *from) return false;
+            if (to && *rec.time > *to) return false;
+            if (severity && (!rec.severity || *rec.severity < *severity)) return false;
+            if (!channels.empty())
+            {
+                if (!rec.channel) return false;
+                std::string channel(*rec.channel);
+                bool matched = false;
+                for (const auto& re : channels)
+                    if ((matched = std::regex_match(channel, re))) break;
+                if (!matched) return false;
+            }
+            return true;
+        };
+
+        for (const auto& file : files)
+            ing::logging::sinks::replay_binary_file(file, filter);
+        core->flush();
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "ing_logcat: " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
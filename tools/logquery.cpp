@@ -0,0 +1,149 @@
+#include <ing/logging.hpp>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const char usage[] =
+        "Usage: ing_logquery [options] file...\n"
+        "Print the blocks of files written by BatchedFile sinks that may hold matching records,\n"
+        "by looking up their sidecar index FILE.idx.\n"
+        "\n"
+        "  --from TIME       skip blocks logged before TIME, \"YYYY-MM-DD HH:MM:SS[.ffffff]\" in local time\n"
+        "  --to TIME         skip blocks logged after TIME\n"
+        "  --channel NAME    keep only blocks that may hold channel NAME, may be repeated\n"
+        "  --severity LEVEL  skip blocks with records below LEVEL only\n"
+        "  --grep REGEX      print only the lines of the blocks matching REGEX\n";
+
+    std::int64_t parse_time(const std::string& str)
+    {
+        using namespace boost::posix_time;
+        auto t = time_from_string(str);
+        if (t.is_special()) throw std::invalid_argument("invalid time " + str);
+        return (t - ptime(boost::gregorian::date(1970, 1, 1))).total_microseconds();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    ing::logging::sinks::index_query query;
+    std::optional<std::regex> grep;
+    std::vector<std::string> files;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string
+            {
+                if (i + 1 >= argc) throw std::invalid_argument(arg + " requires a value");
+                return argv[++i];
+            };
+
+            if (arg == "--help" || arg == "-h")
+            {
+                std::cout << usage;
+                return 0;
+            }
+            else if (arg == "--from") query.from = parse_time(value());
+            else if (arg == "--to") query.to = parse_time(value());
+            else if (arg == "--channel") query.channels.push_back(value());
+            else if (arg == "--severity")
+            {
+                auto level = value();
+                std::transform(level.begin(), level.end(), level.begin(), [](unsigned char c) { return std::toupper(c); });
+                ing::logging::severity_level l;
+                if (!ing::logging::from_string(level, l)) throw std::invalid_argument("invalid severity " + level);
+                query.severity = l;
+            }
+            else if (arg == "--grep") grep.emplace(value());
+            else if (arg.size() > 1 && arg[0] == '-') throw std::invalid_argument("unknown option " + arg);
+            else files.push_back(arg);
+        }
+        if (files.empty()) throw std::invalid_argument("no file");
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "ing_logquery: " << e.what() << '\n' << usage;
+        return 2;
+    }
+
+    try
+    {
+        // Ranges are read in chunks, as unindexed files come as a single range of the whole file.
+        std::vector<char> chunk(std::size_t(1) << 20);
+        std::string line;  // partial line carried over to the next chunk
+        auto print = [&grep](const char* begin, const char* end)
+        {
+            if (std::regex_search(begin, end, *grep))
+                std::cout.write(begin, end - begin) << '\n';
+        };
+
+        for (const auto& file : files)
+        {
+            std::ifstream in(file, std::ios_base::binary);
+            if (!in) throw std::invalid_argument("cannot open " + file);
+
+            ing::logging::sinks::query_index(file, query, [&](std::uint64_t offset, std::uint64_t size)
+            {
+                in.clear();
+                in.seekg(static_cast<std::streamoff>(offset));
+                line.clear();
+                while (size > 0)
+                {
+                    auto n = static_cast<std::streamsize>(std::min<std::uint64_t>(size, chunk.size()));
+                    in.read(chunk.data(), n);
+                    n = in.gcount();
+                    if (n <= 0) break;
+                    size -= static_cast<std::uint64_t>(n);
+
+                    if (!grep)
+                    {
+                        std::cout.write(chunk.data(), n);
+                        continue;
+                    }
+                    const char* p = chunk.data();
+                    const char* end = p + n;
+                    while (p < end)
+                    {
+                        auto eol = std::find(p, end, '\n');
+                        if (eol == end)
+                        {
+                            line.append(p, end);
+                            break;
+                        }
+                        if (line.empty())
+                        {
+                            print(p, eol);
+                        }
+                        else
+                        {
+                            line.append(p, eol);
+                            print(line.data(), line.data() + line.size());
+                            line.clear();
+                        }
+                        p = eol + 1;
+                    }
+                }
+                if (grep && !line.empty())
+                    print(line.data(), line.data() + line.size());
+            });
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "ing_logquery: " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}